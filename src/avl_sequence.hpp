@@ -0,0 +1,339 @@
+#pragma once
+
+#include <iostream>
+
+#include "balancing.hpp"
+
+/**
+ * AVL Sequence Class
+ * A sequence with O(log n) positional access, insertion and erasure.
+ *
+ * Same engine as AVLTree (balancing.hpp), but the nodes are ordered by
+ * position instead of by key: the size augmentation alone locates an
+ * element, no comparisons are made. split_at and concat are O(log n)
+ * through the AVL join.
+ */
+
+template<class T>
+class AVLSequence {
+
+    struct node {
+        T value;
+        int height = -1;
+        int size = 0;
+        node* child[2];
+        node* parent;
+
+        node(const T& value,node* left,node* right,node* parent) : value(value),
+        height(0), size(1), child{left,right}, parent(parent) {}
+
+        node() : child{nullptr,nullptr},parent(nullptr) {}
+    };
+
+    static node NULL_NODE;
+    static node* NILL;
+
+    static node* successor(node* x) {
+        if(x->child[1]!=NILL) {
+            x=x->child[1];
+            while(x->child[0]!=NILL) x=x->child[0];
+            return x;
+        }
+
+        node* y = x->parent;
+        while(y!=NILL && y->child[1]==x) {
+            x = y;
+            y = x->parent;
+        }
+
+        return y;
+    }
+
+    static node* predecessor(node* x) {
+        if(x->child[0]!=NILL) {
+            x=x->child[0];
+            while(x->child[1]!=NILL) {
+                x=x->child[1];
+            }
+            return x;
+        }
+
+        node* y = x->parent;
+        while(y!=NILL && y->child[0]==x) {
+            x = y;
+            y = x->parent;
+        }
+
+        return y;
+    }
+
+
+    /**
+     * private helper function
+     * to help destructor to deallocate all memory
+     * recursively in linear time
+     */
+    void erase_sub_tree(node* x) {
+        if(x==NILL) return;
+        erase_sub_tree(x->child[0]);
+        erase_sub_tree(x->child[1]);
+        delete x;
+    }
+
+    class iterator {
+        friend class AVLSequence<T>;
+        node* it;
+        iterator(node* iter) : it(iter) {}
+    public:
+        iterator() {};
+
+        iterator& operator++() {
+            it = successor(it);
+            return *this;
+        }
+
+        iterator& operator--() {
+            it = predecessor(it);
+            return *this;
+        }
+
+        T& operator*() const {return it->value;}
+        bool operator==(const iterator& rhs) const {return it==rhs.it;}
+        bool operator!=(const iterator& rhs) const {return it!=rhs.it;}
+        iterator& operator=(const iterator& rhs) {
+            it = rhs.it;
+            return *this;
+        }
+
+    };
+
+    node* root = NILL;
+
+
+    /**
+     * A max function
+     */
+    inline int max(int a,int b) {
+        if(a>b) return a;
+        return b;
+    }
+
+
+    inline void relax_augmentation(node* x) {
+        x->height = max(x->child[0]->height,x->child[1]->height)+1;
+        x->size = x->child[0]->size + x->child[1]->size + 1;
+    }
+
+    /**
+     * the shared AVL engine (balancing.hpp) on this sequence, with
+     * relax_augmentation as its augmentation hook
+     */
+    auto engine() {
+        return make_balancer(root,NILL,[this](node* x) {relax_augmentation(x);});
+    }
+
+    /**
+     * Finds the node at position k
+     * 0 <= k < root->size
+     */
+    node* select(int k) {
+        node* x = root;
+        while(true) {
+            if(x->child[0]->size>k) x = x->child[0];
+            else if(x->child[0]->size==k) return x;
+            else {
+                k -= x->child[0]->size+1;
+                x = x->child[1];
+            }
+        }
+    }
+
+    /**
+     * returns the root of an AVL tree holding the sequence l, k, r
+     * l and r are roots of valid AVL trees (possibly NILL), k is a single node
+     * O(|height(l)-height(r)|+1)
+     * uses the root member as scratch space
+     */
+    node* join(node* l,node* k,node* r) {
+        if(l!=NILL) l->parent = NILL;
+        if(r!=NILL) r->parent = NILL;
+
+        node* t[2] = {l,r};
+        // d is the side of the higher tree, k goes down its inner spine
+        int d = r->height > l->height;
+        if(t[d]->height > t[!d]->height+1) {
+            root = t[d];
+            node* c = t[d];
+            node* p = NILL;
+            while(c->height > t[!d]->height+1) {
+                p = c;
+                c = c->child[!d];
+            }
+            k->child[d] = c;
+            if(c!=NILL) c->parent = k;
+            k->child[!d] = t[!d];
+            if(t[!d]!=NILL) t[!d]->parent = k;
+            k->parent = p;
+            p->child[!d] = k;
+            engine().avl_fix_tree(k,root);
+            return root;
+        }
+
+        k->child[0] = l;
+        k->child[1] = r;
+        k->parent = NILL;
+        if(l!=NILL) l->parent = k;
+        if(r!=NILL) r->parent = k;
+        relax_augmentation(k);
+        return k;
+    }
+
+    /**
+     * splits the tree rooted at t into a tree l holding the first pos
+     * elements and a tree r holding the rest, O(log n)
+     */
+    void split(node* t,int pos,node*& l,node*& r) {
+        if(t==NILL) {
+            l = r = NILL;
+            return;
+        }
+
+        node* tl = t->child[0];
+        node* tr = t->child[1];
+        if(pos<=tl->size) {
+            node* b;
+            split(tl,pos,l,b);
+            r = join(b,t,tr);
+        } else {
+            node* a;
+            split(tr,pos-tl->size-1,a,r);
+            l = join(tl,t,a);
+        }
+    }
+
+    public:
+    /**
+     * inserts val so that it ends up at position pos
+     * 0 <= pos <= size()
+     */
+    void insert_at(int pos,const T& val) {
+        node* z = new node(val,NILL,NILL,NILL);
+        if(root==NILL) {
+            root = z;
+            return;
+        }
+
+        // z becomes the right child of the last node before pos
+        // or the left child of the node at pos when there is none
+        node* y;
+        int d = 1;
+        if(pos==root->size) {
+            y = root;
+        } else {
+            y = select(pos);
+            if(y->child[0]==NILL) d = 0;
+            else y = y->child[0];
+        }
+        if(d) {
+            while(y->child[1]!=NILL) y = y->child[1];
+        }
+        y->child[d] = z;
+
+        z->parent = y;
+        engine().avl_fix_tree(y,root);
+    }
+
+    void push_back(const T& val) {
+        insert_at(size(),val);
+    }
+
+    /**
+     * erases the element at position pos
+     * 0 <= pos < size()
+     */
+    void erase_at(int pos) {
+        node* z = select(pos);
+        engine().avl_unlink(z);
+        delete z;
+    }
+
+    /**
+     * element at position pos
+     * 0 <= pos < size()
+     */
+    T& at(int pos) {
+        return select(pos)->value;
+    }
+
+    /**
+     * keeps the first pos elements and moves the rest to the (cleared) sequence right
+     * O(log n)
+     */
+    void split_at(int pos,AVLSequence<T>& right) {
+        right.clear();
+        node* t = root;
+        node* l;
+        node* r;
+        split(t,pos,l,r);
+        root = l;
+        right.root = r;
+    }
+
+    /**
+     * appends all elements of other, other becomes empty
+     * O(log n)
+     */
+    void concat(AVLSequence<T>& other) {
+        if(other.root==NILL) return;
+        if(root==NILL) {
+            root = other.root;
+            other.root = NILL;
+            return;
+        }
+
+        node* k = other.select(0);
+        other.engine().avl_unlink(k);
+
+        node* l = root;
+        root = join(l,k,other.root);
+        other.root = NILL;
+    }
+
+    void clear() {
+        erase_sub_tree(root);
+        root = NILL;
+    }
+
+    bool empty() {
+        return !(root->size);
+    }
+
+    unsigned size() {
+        return root->size;
+    }
+
+    iterator begin() {
+        node* x = root;
+        if(x!=NILL) {
+            while(x->child[0]!=NILL) {
+                x=x->child[0];
+            }
+        }
+        return iterator(x);
+    }
+
+    iterator end() {
+        return iterator(NILL);
+    }
+
+    ~AVLSequence() {
+        erase_sub_tree(root);
+    }
+};
+
+template<class T>
+typename AVLSequence<T>::node AVLSequence<T>::NULL_NODE = {};
+
+
+template<class T>
+typename AVLSequence<T>::node* AVLSequence<T>::NILL = &AVLSequence<T>::NULL_NODE;
@@ -1,5 +1,18 @@
+#pragma once
+
 #include <functional>
 #include <iostream>
+#include <utility>
+#include <vector>
+
+#include "balancing.hpp"
+#include "batch_traversal.hpp"
+#include "key_prefix.hpp"
+#include "lookup_cache.hpp"
+#include "negative_filter.hpp"
+#include "parallel_traversal.hpp"
+#include "relayout.hpp"
+#include "tree_stats.hpp"
 
 /**
  * AVL Tree Class
@@ -8,19 +21,26 @@
 
 template<class T,typename Comp = std::less<T>>
 class AVLTree {
+    /**
+     * inline key prefix compared before the keys, empty unless T is
+     * std::string ordered by std::less, see key_prefix.hpp
+     */ 
+    typedef key_prefix<T,Comp> prefix;
     
-    struct node {    
+    struct node : prefix::field {
         T key;
         int height = -1;
         int size = 0;
-        node* left;
-        node* right;
+        node* child[2]; // left, right
         node* parent;
+        bool dead = false;
 
         node(const T& key,node* left,node* right,node* parent) : key(key), 
-        left(left), right(right), parent(parent), height(0), size(1) {}
+        child{left,right}, parent(parent), height(0), size(1) {
+            prefix::store(*this,key);
+        }
 
-        node() : left(nullptr),right(nullptr),parent(nullptr) {}   
+        node() : child{nullptr,nullptr},parent(nullptr) {}   
     };
 
     Comp comp;
@@ -29,14 +49,14 @@ class AVLTree {
     static node* NILL;
     
     static node* successor(node* x) {
-        if(x->right!=NILL) {
-            x=x->right;
-            while(x->left!=NILL) x=x->left;
+        if(x->child[1]!=NILL) {
+            x=x->child[1];
+            while(x->child[0]!=NILL) x=x->child[0];
             return x;
         }
 
         node* y = x->parent;
-        while(y!=NILL && y->right==x) {
+        while(y!=NILL && y->child[1]==x) {
             x = y;
             y = x->parent;
         }
@@ -45,16 +65,16 @@ class AVLTree {
     }
 
     static node* predecessor(node* x) {
-        if(x->left!=NILL) {
-            x=x->left;
-            while(x->right!=NILL) {
-                x=x->right;
+        if(x->child[0]!=NILL) {
+            x=x->child[0];
+            while(x->child[1]!=NILL) {
+                x=x->child[1];
             }
             return x;
         }
 
-        node* y = y->parent;
-        while(y!=NILL && y->left==x) {
+        node* y = x->parent;
+        while(y!=NILL && y->child[0]==x) {
             x = y;
             y = x->parent;
         }
@@ -63,6 +83,16 @@ class AVLTree {
     }
 
 
+    /**
+     * successor that skips tombstones
+     */ 
+    static node* next_live(node* x) {
+        do {
+            x = successor(x);
+        } while(x->dead);
+        return x;
+    }
+
     /**
      * private helper function
      * to help destructor to deallocate all memory
@@ -70,9 +100,9 @@ class AVLTree {
      */ 
     void erase_sub_tree(node* x) {
         if(x==NILL) return;
-        erase_sub_tree(x->left);
-        erase_sub_tree(x->right);
-        delete x;
+        erase_sub_tree(x->child[0]);
+        erase_sub_tree(x->child[1]);
+        arena.release(x);
     }
 
     class iterator {
@@ -83,12 +113,14 @@ class AVLTree {
         iterator() {};
 
         iterator& operator++() {
-            it = successor(it);
+            it = next_live(it);
             return *this;
         }
 
         iterator& operator--() {
-            it = predecessor(it);
+            do {
+                it = predecessor(it);
+            } while(it->dead);
             return *this;
         }
 
@@ -104,28 +136,34 @@ class AVLTree {
 
     node* root = NILL;
 
+    /**
+     * number of allocated nodes, live ones and tombstones
+     * root->size only counts the live ones
+     */ 
+    int node_count = 0;
+    unsigned long long rotation_count = 0;
+    bool lazy_erase = false;
+    double max_dead_fraction = 0.25;
 
     /**
-     * A private helper function for the erase method
-     * replaces subtree rooted at u with subtree rooted at v
-     * assigns root when necessary
-     * DOES NOT FIX AUGMENTATION OR PRESERVE AVL PROPERTIES
+     * optional cache of find / order_of_key results, see enable_lookup_cache
+     * every mutation bumps its version
      */ 
-    inline void transplant(node* u,node* v) {
-        if(u->parent==NILL) {
-            root = v;
-        } else if(u->parent->left == u) {
-            u->parent->left = v;
-        } else {
-            u->parent->right = v;
-        }
+    lookup_cache<T,node> cache;
 
-        if(v!=NILL) {
-            v->parent = u->parent;
-        }
-    }
+    /**
+     * optional filter of the live keys, see enable_negative_filter
+     */ 
+    negative_filter<T> filter;
 
+    /**
+     * blocks the nodes are moved to by relayout, frees every node
+     */ 
+    node_arena<node> arena;
 
+    inline bool equivalent(const T& a,const T& b) {
+        return !comp(a,b) && !comp(b,a);
+    }
 
 
     /**
@@ -138,198 +176,499 @@ class AVLTree {
 
     
     inline void relax_augmentation(node* x) {
-        x->height = max(x->left->height,x->right->height)+1;
-        x->size = x->left->size + x->right->size + 1;
+        x->height = max(x->child[0]->height,x->child[1]->height)+1;
+        x->size = x->child[0]->size + x->child[1]->size + (x->dead?0:1);
     }
 
     /**
-     * x is not NILL
-     * x must have a right child
-     * must adjust root when necessary
-     * must fix augmentation code locally
+     * the shared AVL engine (balancing.hpp) on this tree, with
+     * relax_augmentation as its augmentation hook
      */ 
-    void single_rotate_left(node* x) {
-        node* y = x->right;
-        
-        x->right = y->left;
-        if(x->right!=NILL) x->right->parent = x;
-        
-        y->parent = x->parent;
-        if(y->parent==NILL) {
-            root = y;
-        } else if(x == x->parent->left) {
-            y->parent->left = y;
-        } else {
-            y->parent->right = y;
-        }
-
-        y->left = x;
-        x->parent = y;
+    auto engine() {
+        return make_balancer(root,NILL,[this](node* x) {relax_augmentation(x);},&rotation_count);
+    }
 
-        relax_augmentation(x);
-        relax_augmentation(y);
+    /**
+     * A helper function for the erase(iterator) method
+     * z can't be NILL
+     */ 
+    void erase(node* z) {
+        engine().avl_unlink(z);
+        arena.release(z);
+        node_count--;
     }
 
     /**
-     * x is not NILL
-     * x must have a left child
-     * must adjust root when necessary
-     * must fix augmentation code locally
+     * hangs z, unlinked and holding its new key, into the tree as a leaf
+     * and rebalances, returns its rank
+     * there must be no live node equivalent to z->key, a tombstone that is
+     * gets freed first
      */ 
-    void single_rotate_right(node* x) {
-        node* y = x->left;
-        
-        x->left = y->right;
-        if(x->left!=NILL) x->left->parent = x;
-        
-        y->parent = x->parent;
-        if(y->parent==NILL) {
-            root = y;
-        } else if(x == x->parent->left) {
-            y->parent->left = y;
-        } else {
-            y->parent->right = y;
-        }
+    int link(node* z) {
+        typename prefix::field p = prefix::make(z->key);
+        while(true) {
+            node* y = NILL;
+            node* x = root;
+            node* candidate = NILL;
+            int rank = 0;
+            bool r = false;
+
+            while(x!=NILL) {
+                y = x;
+                r = goes_right(x,z->key,p);
+                candidate = r ? candidate : x;
+                rank += r ? x->child[0]->size + !x->dead : 0;
+                x = x->child[r];
+            }
 
-        y->right = x;
-        x->parent = y;
+            if(matches(candidate,z->key,p)) {
+                erase(candidate);
+                continue;
+            }
 
-        x->height = max(x->left->height,x->right->height) + 1;
-        x->size = x->left->size + x->right->size + 1;
-        
-        relax_augmentation(x);
-        relax_augmentation(y);
+            z->child[0] = z->child[1] = NILL;
+            z->parent = y;
+            z->height = 0;
+            z->size = 1;
+            if(y==NILL) root = z;
+            else y->child[r] = z;
+
+            engine().avl_fix_tree(z,root);
+            return rank;
+        }
     }
 
     /**
-     * x must have right child and right-left grandchild
-     */
-    void double_rotate_left(node* x) {
-        single_rotate_right(x->right);
-        single_rotate_left(x);
+     * number of live nodes before x, one walk up to the root
+     */ 
+    int rank_of(node* x) {
+        int rank = x->child[0]->size;
+        for(;x->parent!=NILL;x=x->parent) {
+            if(x==x->parent->child[1]) rank += x->parent->child[0]->size + !x->parent->dead;
+        }
+        return rank;
     }
 
-    void double_rotate_right(node* x) {
-        single_rotate_left(x->left);
-        single_rotate_right(x);
+    /**
+     * whether val belongs to the right of x, i.e. comp(x->key,val),
+     * the inline key prefixes decide first
+     */ 
+    inline bool goes_right(node* x,const T& val,const typename prefix::field& p) {
+        int c = prefix::compare(*x,p);
+        return c<0 || (c==0 && comp(x->key,val));
     }
 
-    void rotate_left(node* x) {
-        node* r = x->right;
-        if(r->right->height>r->left->height) single_rotate_left(x);
-        else double_rotate_left(x);
+    /**
+     * whether x, NILL or a node not smaller than val, holds a key equivalent to val
+     */ 
+    inline bool matches(node* x,const T& val,const typename prefix::field& p) {
+        return x!=NILL && prefix::compare(*x,p)==0 && !comp(val,x->key);
     }
 
-    void rotate_right(node* x) {
-        node* l = x->left;
-        if(l->left->height>l->right->height) single_rotate_right(x);
-        else double_rotate_right(x);
+    /**
+     * returns the node holding a key equivalent to val or NILL
+     * Descents take one comparison per level and step with
+     * x = x->child[goes_right], without an early exit, so the loop
+     * condition is their only branch. The smallest node on the path that
+     * is not smaller than val is the only one that can match.
+     */ 
+    node* find_node(const T& val) {
+        typename prefix::field p = prefix::make(val);
+        node* x = root;
+        node* candidate = NILL;
+        while(x!=NILL) {
+            bool r = goes_right(x,val,p);
+            candidate = r ? candidate : x;
+            x = x->child[r];
+        }
+        return matches(candidate,val,p) && !candidate->dead ? candidate : NILL;
     }
 
     /**
-     * locally modifies tree
-     * updates augmentation
-     * rebalances tree if there if there is an avl property vialation at node
-     * i.e abs(balance factor(x)) >1 
+     * returns the node holding a key equivalent to val or NILL
+     * K is T or, with a transparent comparator, any type Comp can compare with T
      */ 
-    void rebalance(node* x) {
-        int hl = x->left->height;
-        int hr = x->right->height;
-        if(hr>hl+1) rotate_left(x);
-        else if(hl>hr+1) rotate_right(x);
-        else relax_augmentation(x);
+    template<class K>
+    node* find_node(const K& val) {
+        node* x = root;
+        node* candidate = NILL;
+        while(x!=NILL) {
+            bool r = comp(x->key,val);
+            candidate = r ? candidate : x;
+            x = x->child[r];
+        }
+        if(candidate==NILL || comp(val,candidate->key) || candidate->dead) return NILL;
+        return candidate;
     }
 
     /**
-     * given a node x in a subtree rooted at r 
-     * where there is an avl or augmentation violation
-     * fix_tree(x,r) modifies the subtree and brings it 
-     * back to a valid AVL state
+     * returns number of nodes smaller than val
+     * one comparison per level, of the inline key prefixes first
      */ 
-    void fix_tree(node* x,node* r) {
-        while(x!=r->parent) {
-            rebalance(x);
-            x=x->parent;
+    int order_of_key_node(const T& val) {
+        typename prefix::field p = prefix::make(val);
+        node* x = root;
+        int pos = 0;
+        while(x!=NILL) {
+            bool r = goes_right(x,val,p);
+            pos += r ? x->child[0]->size + !x->dead : 0;
+            x = x->child[r];
         }
-    }
-    
 
+        return pos;
+    }
 
     /**
-     * A helper function for the erase(iterator) method
-     * z can't be NILL
+     * returns number of nodes smaller than val
+     * only uses comp, one comparison per level
      */ 
-    void erase(node* z) {
-        if(z->left==NILL) {
-            transplant(z,z->right);
-            fix_tree(z->parent,root);
-        } else if(z->right==NILL) {
-            transplant(z,z->left);
-            fix_tree(z->parent,root);
-        } else {
-            node* y = successor(z); //y is not NILL and y has no left child cause z->right is not NILL
-            if(y->parent!=z) {
-                transplant(y,y->right);
-                fix_tree(y->parent,z);
+    template<class K>
+    int order_of_key_node(const K& val) {
+        node* x = root;
+        int p = 0;
+        while(x!=NILL) {
+            bool r = comp(x->key,val);
+            p += r ? x->child[0]->size + !x->dead : 0;
+            x = x->child[r];
+        }
 
-                y->right = z->right;
-                y->right->parent = y;
+        return p;
+    }
+
+    /**
+     * Finds the kth smallest live node
+     * 0 <= k < root->size
+     */ 
+    node* select(int k) {
+        node* x = root;
+        while(true) {
+            int self = x->dead?0:1;
+            if(x->child[0]->size>k) x = x->child[0];
+            else if(x->child[0]->size==k && self) return x;
+            else {
+                k -= x->child[0]->size+self;
+                x = x->child[1];
             }
+        }
+    }
 
-            transplant(z,y);
-            y->left = z->left;
-            y->left->parent = y;
-            
-            fix_tree(y,root);                
+    /**
+     * turns a live node into a tombstone
+     * only the sizes on the path to the root change
+     */ 
+    void kill(node* x) {
+        x->dead = true;
+        for(node* y = x;y!=NILL;y=y->parent) y->size--;
+    }
+
+    /**
+     * turns a tombstone back into a live node
+     */ 
+    void revive(node* x) {
+        cache.invalidate();
+        filter.add(x->key);
+        x->dead = false;
+        for(node* y = x;y!=NILL;y=y->parent) y->size++;
+    }
+
+    /**
+     * appends the live nodes of the subtree rooted at x to nodes
+     * in sorted order and frees the tombstones
+     */ 
+    void collect_live(node* x,std::vector<node*>& nodes) {
+        if(x==NILL) return;
+        collect_live(x->child[0],nodes);
+        node* r = x->child[1];
+        if(x->dead) {
+            arena.release(x);
+            node_count--;
+        } else {
+            nodes.push_back(x);
         }
+        collect_live(r,nodes);
+    }
 
-        delete z;
+    /**
+     * builds a balanced tree from nodes[lo..hi] and returns its root
+     */ 
+    node* build_balanced(std::vector<node*>& nodes,int lo,int hi,node* parent) {
+        if(lo>hi) return NILL;
+        int mid = lo+(hi-lo)/2;
+        node* x = nodes[mid];
+        x->parent = parent;
+        x->child[0] = build_balanced(nodes,lo,mid-1,x);
+        x->child[1] = build_balanced(nodes,mid+1,hi,x);
+        relax_augmentation(x);
+        return x;
     }
 
     public:
+    /**
+     * the type of the comparator the keys are ordered by
+     */
+    typedef Comp key_compare;
+
     iterator find(const T& val) {
-        node* x = root;
-        while(x!=NILL) {
-            if(comp(x->key,val)) x = x->right;
-            else if(comp(val,x->key)) x = x->left;
-            else return iterator(x);
+        if(filter.enabled() && !filter.may_contain(val)) return iterator(NILL);
 
+        node* x;
+        if(cache.enabled()) {
+            x = cache.find(val,[this](const T& a,const T& b) {return equivalent(a,b);},
+                [this](const T& key) {return find_node(key);});
+        } else {
+            x = find_node(val);
         }
-        return iterator(NILL);
+
+        if(x==NILL && filter.enabled()) filter.false_positive();
+        return iterator(x);
+    }
+
+    /**
+     * heterogeneous lookup
+     * only takes part in overload resolution when Comp::is_transparent exists
+     * e.g. std::less<> lets a tree of std::string be searched with a string_view
+     * without building a temporary key
+     */ 
+    template<class K,class C = Comp,class = typename C::is_transparent>
+    iterator find(const K& val) {
+        return iterator(find_node(val));
     }
 
     /**
      * Inserts a new node into the tree and rebalances it accordingly
      * to preserve avl properties if the node is not present
      * If the value already exists in the tree it does nothing.
+     * Returns an iterator to the element equivalent to val and its rank,
+     * counted on the way down, whether it was inserted or already present
      */ 
-    void insert(const T& val) {
+    std::pair<iterator,int> insert(const T& val) {
+        typename prefix::field p = prefix::make(val);
         node* y = NILL;
         node* x = root;
+        node* candidate = NILL; // smallest node on the path not smaller than val
+        int rank = 0;
+        int candidate_rank = 0;
+        bool r = false;
 
         while(x!=NILL) {
             y = x;
-            
-            if(comp(x->key,val)) x = x->right;
-            else if(comp(val,x->key)) x = x->left;
-            else return; //value already in tree
+            r = goes_right(x,val,p);
+            candidate = r ? candidate : x;
+            candidate_rank = r ? candidate_rank : rank;
+            rank += r ? x->child[0]->size + !x->dead : 0;
+            x = x->child[r];
+        }
+
+        if(matches(candidate,val,p)) {
+            if(candidate->dead) revive(candidate);
+            return std::make_pair(iterator(candidate),candidate_rank+candidate->child[0]->size); //value already in tree
         }
         
         node* z = new node(val,NILL,NILL,NILL);
+        node_count++;
+        cache.invalidate();
+        filter.add(val);
         z->parent = y;
 
         if(y==NILL) root = z;
-        else if(comp(val,y->key)) y->left = z;
-        else y->right = z;
+        else y->child[r] = z;
 
-        fix_tree(z,root);
+        engine().avl_fix_tree(z,root);
+        return std::make_pair(iterator(z),rank);
     }
 
+    /**
+     * In lazy erase mode the node only becomes a tombstone and the tree
+     * is rebuilt once tombstones exceed max_dead_fraction of the nodes
+     */ 
     void erase(iterator it) {
-        erase(it.it);
+        cache.invalidate();
+        filter.remove(it.it->key);
+        if(lazy_erase) {
+            kill(it.it);
+            if(node_count-root->size > max_dead_fraction*node_count) rebuild();
+        } else {
+            erase(it.it);
+        }
+    }
+
+    /**
+     * Erases the element equivalent to val, one descent
+     * returns false if there is none
+     */ 
+    bool erase(const T& val) {
+        if(filter.enabled() && !filter.may_contain(val)) return false;
+        node* z = find_node(val);
+        if(z==NILL) {
+            if(filter.enabled()) filter.false_positive();
+            return false;
+        }
+        erase(iterator(z));
+        return true;
+    }
+
+    /**
+     * Erases the kth smallest element, k is 0 indexed
+     * returns false if k is out of range
+     */ 
+    bool erase_by_order(int k) {
+        if(k<0 || k>=(int)root->size) return false;
+        erase(iterator(select(k)));
+        return true;
+    }
+
+    /**
+     * Changes the key of the element at it to new_key and returns its new rank.
+     * If new_key still falls strictly between the neighbouring nodes the key
+     * is replaced in place without any rebalancing, otherwise the node is
+     * unlinked and hung back in at its new place. Either way the node is
+     * neither freed nor reallocated, it and all other iterators stay valid.
+     * Returns -1 and changes nothing if another element is equivalent to new_key.
+     */ 
+    int update_key(iterator it,const T& new_key) {
+        node* z = it.it;
+        node* prev = predecessor(z);
+        node* next = successor(z);
+        bool in_place = (prev==NILL || comp(prev->key,new_key)) && (next==NILL || comp(new_key,next->key));
+        if(!in_place) {
+            node* other = find_node(new_key);
+            if(other!=NILL && other!=z) return -1;
+        }
+
+        cache.invalidate();
+        filter.remove(z->key);
+        filter.add(new_key);
+        if(in_place) {
+            z->key = new_key;
+            prefix::store(*z,new_key);
+            return rank_of(z);
+        }
+
+        engine().avl_unlink(z);
+        z->key = new_key;
+        prefix::store(*z,new_key);
+        return link(z);
+    }
+
+    /**
+     * Enables or disables lazy erase mode
+     * existing tombstones stay until the next rebuild
+     */ 
+    void set_lazy_erase(bool enable,double max_dead = 0.25) {
+        lazy_erase = enable;
+        max_dead_fraction = max_dead;
+    }
+
+    /**
+     * number of tombstones currently in the tree
+     */ 
+    int tombstones() {
+        return node_count-root->size;
+    }
+
+    /**
+     * frees all tombstones and relinks the live nodes into a
+     * perfectly balanced tree in linear time
+     * iterators to live elements stay valid
+     */ 
+    void rebuild() {
+        cache.invalidate();
+        std::vector<node*> nodes;
+        nodes.reserve(root->size);
+        collect_live(root,nodes);
+        root = build_balanced(nodes,0,(int)nodes.size()-1,NILL);
+    }
+
+
+
+    /**
+     * Puts a direct mapped cache of num_slots (rounded up to a power of two)
+     * find / order_of_key results in front of the tree, for read mostly
+     * workloads that keep asking for the same hot keys. A hit skips the
+     * descent, a miss costs one hash more than the descent, and every insert
+     * or erase invalidates the whole cache in O(1), so no bound gets worse.
+     * Heterogeneous lookups bypass it. num_slots = 0 disables it.
+     */ 
+    void enable_lookup_cache(std::size_t num_slots,std::function<std::size_t(const T&)> hash = std::hash<T>()) {
+        cache.enable(num_slots,hash);
+    }
+
+    /**
+     * lookups answered by the cache and lookups that had to descend,
+     * counted since it was enabled or the last reset
+     */ 
+    unsigned long long lookup_cache_hits() {
+        return cache.hits;
+    }
+
+    unsigned long long lookup_cache_misses() {
+        return cache.misses;
+    }
+
+    void reset_lookup_cache_stats() {
+        cache.reset_stats();
+    }
+
+    /**
+     * Keeps a counting Bloom filter of the keys in budget_bytes of memory,
+     * updated by every insert and erase, so that find and erase of an
+     * absent key usually return without a descent. Roughly 10 bytes per
+     * key give a false positive rate around 1%. Building it is O(n),
+     * budget_bytes = 0 disables it.
+     */ 
+    void enable_negative_filter(std::size_t budget_bytes,std::function<std::size_t(const T&)> hash = std::hash<T>()) {
+        filter.enable(budget_bytes,hash);
+        for(iterator it=begin();it!=end();++it) filter.add(it.it->key);
     }
 
+    /**
+     * queries, rejections, false positives and memory of the filter
+     */ 
+    const negative_filter<T>& negative_filter_stats() {
+        return filter;
+    }
 
+    void reset_negative_filter_stats() {
+        filter.reset_stats();
+    }
+
+    /**
+     * Moves every node, tombstones included, into one contiguous block in
+     * the order of policy, keeping the shape and the augmentation, so a
+     * tree that went through many inserts and erases descends through as
+     * few cache lines and pages as a freshly built one. O(n) time,
+     * a van_emde_boas layout takes O(n log log n).
+     * Invalidates iterators.
+     */ 
+    void relayout(relayout_policy policy = van_emde_boas) {
+        begin_relayout(policy);
+        relayout_step(std::size_t(-1));
+    }
+
+    void compact() {
+        relayout(van_emde_boas);
+    }
+
+    /**
+     * Incremental relayout: begin_relayout plans the order in one read only
+     * O(n) traversal, then every relayout_step moves at most max_nodes
+     * nodes and returns true once the pass is complete.
+     * The tree can be used and modified in between, nodes inserted
+     * meanwhile stay outside the block until the next pass.
+     * Every step invalidates iterators.
+     */ 
+    void begin_relayout(relayout_policy policy = van_emde_boas) {
+        arena.begin(root,NILL,policy);
+    }
+
+    bool relayout_step(std::size_t max_nodes) {
+        cache.invalidate();
+        return arena.step(root,NILL,max_nodes);
+    }
+
+    bool relayout_pending() {
+        return arena.pending();
+    }
 
     bool empty() {
         return !(root->size);
@@ -338,14 +677,45 @@ class AVLTree {
     unsigned size() {
         return root->size;
     }
+
+    /**
+     * Number of single rotations performed since the tree was created
+     */ 
+    unsigned long long rotations() {
+        return rotation_count;
+    }
+
+    /**
+     * Bytes used by the nodes, the allocator and the optional structures,
+     * see tree_stats.hpp. The approximate mode is O(1) in the number of
+     * nodes, the exact mode walks them. Tombstones count as nodes.
+     */ 
+    tree_memory_usage memory_usage(stats_mode mode = stats_approximate) {
+        std::size_t auxiliary = sizeof(*this)+cache.memory_usage()+filter.memory_usage()+arena.scratch_bytes();
+        return measure_memory(root,NILL,node_count,arena.block_nodes(),arena.block_bytes(),auxiliary,mode,
+            [this](node* x) {return arena.in_block(x);});
+    }
+
+    /**
+     * Depth histogram, average and max depth and rotations, see tree_stats.hpp.
+     * The approximate mode samples O(log n) descents over the live nodes,
+     * the max depth is exact in both modes (the height of the root).
+     */ 
+    tree_shape_stats shape_stats(stats_mode mode = stats_approximate) {
+        tree_shape_stats s = measure_shape(root,NILL,node_count,mode,[](node* x) {return x->dead?0:1;});
+        s.max_depth = root->height;
+        s.rotations = rotation_count;
+        return s;
+    }
     
     iterator begin() {
         node* x = root;
         if(x!=NILL) {
-            while(x->left!=NILL) {
-                x=x->left;
+            while(x->child[0]!=NILL) {
+                x=x->child[0];
             }
         }
+        if(x->dead) x = next_live(x);
         return iterator(x);
     }
 
@@ -364,18 +734,8 @@ class AVLTree {
      * k is 0 indexed
      */ 
     iterator find_by_order(int k) {
-        k++;
-        node* x = root;
-        while(x!=NILL) {
-            if(x->left->size>=k) x = x->left;
-            else if(x->left->size+1==k) return iterator(x);
-            else {
-                k-=(x->left->size+1);
-                x = x->right;
-            }
-        }
-
-        return iterator(x);
+        if(k<0 || k>=root->size) return iterator(NILL);
+        return iterator(select(k));
     }
 
     /**
@@ -383,21 +743,77 @@ class AVLTree {
      * 
      */
     int order_of_key(const T& val) {
-        node* x = root;
-        int p = 0;
-        while(x!=NILL) {
-            if(x->key==val) {
-                p+=x->left->size;
-                return p;
-            } else if(x->key>val) {
-                x=x->left;
-            } else {
-                p += x->left->size+1;
-                x = x->right;
-            }
+        if(cache.enabled()) {
+            return cache.rank(val,[this](const T& a,const T& b) {return equivalent(a,b);},
+                [this](const T& key) {return order_of_key_node(key);});
         }
+        return order_of_key_node(val);
+    }
 
-        return p;
+    template<class K,class C = Comp,class = typename C::is_transparent>
+    int order_of_key(const K& val) {
+        return order_of_key_node(val);
+    }
+
+    /**
+     * out[i] = the key of rank ranks[i], for every i, in one shared traversal
+     * O(k log(n/k)) for k ranks instead of k separate descents
+     * ranks must be sorted and 0 <= ranks[i] < size()
+     */ 
+    void select_many(const std::vector<int>& ranks,std::vector<T>& out) {
+        out.resize(ranks.size());
+        select_many_nodes(root,NILL,ranks,[](node* x) {return x->dead?0:1;},[&out](int i,node* x) {
+            out[i] = x->key;
+        });
+    }
+
+    /**
+     * out[i] = order_of_key(keys[i]), for every i, in one shared traversal
+     * keys must be sorted by Comp
+     */ 
+    void rank_many(const std::vector<T>& keys,std::vector<int>& out) {
+        out.resize(keys.size());
+        rank_many_nodes(root,NILL,keys,[this](node* x,const T& key) {return comp(x->key,key);},
+            [](node* x) {return x->dead?0:1;},[&out](int i,int rank) {out[i] = rank;});
+    }
+
+    /**
+     * calls f(key) on every key, the keys are split into rank ranges of
+     * equal length that are processed in parallel, in order within a range
+     * f must be safe to call concurrently
+     * the tree must not be modified until it returns
+     * num_threads = 0 uses std::thread::hardware_concurrency()
+     */ 
+    template<class F>
+    void parallel_for_each(F f,unsigned num_threads = 0) {
+        unsigned chunks = parallel_rank_chunks(root->size,num_threads);
+        parallel_rank_ranges(root,chunks,[this](int k) {return select(k);},[&f](unsigned,node* x,int count) {
+            for(int i=0;i<count;i++,x=next_live(x)) f(x->key);
+        });
+    }
+
+    /**
+     * returns init op k0 op k1 op ... op kn-1 over the keys in sorted order
+     * every rank range is folded on its own thread, then the partial results
+     * are combined in rank order, so the result is deterministic for an
+     * associative op (op does not need to be commutative)
+     * op takes two R, T must be convertible to R
+     */ 
+    template<class R,class Op>
+    R parallel_reduce(R init,Op op,unsigned num_threads = 0) {
+        if(root->size==0) return init;
+
+        unsigned chunks = parallel_rank_chunks(root->size,num_threads);
+        std::vector<R> partial(chunks,init);
+        parallel_rank_ranges(root,chunks,[this](int k) {return select(k);},[&](unsigned c,node* x,int count) {
+            R acc = x->key;
+            x = next_live(x);
+            for(int i=1;i<count;i++,x=next_live(x)) acc = op(acc,x->key);
+            partial[c] = acc;
+        });
+
+        for(unsigned c=0;c<chunks;c++) init = op(init,partial[c]);
+        return init;
     }
 
     ~AVLTree() {
@@ -0,0 +1,351 @@
+#pragma once
+
+/**
+ * The rebalancing engines shared by the tree and sequence headers, so the
+ * trees ordered by key and the sequences ordered by position rotate and
+ * rebalance with the same code:
+ * - transplant and single_rotate, a rotation by direction
+ * - AVL: avl_fix_tree and avl_unlink
+ * - red-black: rb_insert_fixup and rb_unlink
+ * - splay: single_splay, splay and semi_splay
+ *
+ * A tree calls them through a balancer, made by make_balancer for the call
+ * and inlined away, which refers to the tree's root, its NILL and
+ * optionally its rotation counter, and holds relax. relax(x) recomputes
+ * the augmentation of the node x from its children, it is the hook every
+ * tree puts its own augmentation (heights, sizes, tombstones, aggregates)
+ * behind.
+ *
+ * node must have child[2] (left, right) and parent fields, NILL
+ * terminated, and the root's parent is NILL. The AVL steps also read the
+ * height field that relax keeps, -1 on NILL, the red-black steps a color
+ * field, black on NILL. The red-black steps may start relaxing at NILL,
+ * whose parent they set, so relax must skip NILL there.
+ */
+
+enum rb_color {red,black};
+
+template<class node,class Relax>
+struct balancer {
+    node*& root;
+    node* nill;
+    Relax relax;
+    unsigned long long* rotations;
+
+    /**
+     * replaces subtree rooted at u with subtree rooted at v
+     * assigns root when necessary, leaves the parent of NILL alone
+     * DOES NOT FIX AUGMENTATION OR PRESERVE BALANCE
+     */
+    void transplant(node* u,node* v) {
+        if(u->parent==nill) {
+            root = v;
+        } else {
+            u->parent->child[u->parent->child[1]==u] = v;
+        }
+
+        if(v!=nill) {
+            v->parent = u->parent;
+        }
+    }
+
+    /**
+     * x is not NILL
+     * rotates x down to side d (0 left, 1 right), its child on the other
+     * side, which must not be NILL, takes its place
+     * adjusts root when necessary and relaxes x, then its new parent
+     */
+    void single_rotate(node* x,int d) {
+        if(rotations) ++*rotations;
+        node* y = x->child[!d];
+
+        x->child[!d] = y->child[d];
+        if(x->child[!d]!=nill) x->child[!d]->parent = x;
+
+        y->parent = x->parent;
+        if(y->parent==nill) {
+            root = y;
+        } else {
+            y->parent->child[x==x->parent->child[1]] = y;
+        }
+
+        y->child[d] = x;
+        x->parent = y;
+
+        relax(x);
+        relax(y);
+    }
+
+    /**
+     * x is too high on side !d, it goes down to side d
+     * with a double rotation when the inner grandchild is the higher one
+     */
+    void avl_rotate(node* x,int d) {
+        node* c = x->child[!d];
+        if(c->child[d]->height>c->child[!d]->height) single_rotate(c,!d);
+        single_rotate(x,d);
+    }
+
+    /**
+     * relaxes x, rotating when abs(balance factor(x)) > 1
+     */
+    void avl_rebalance(node* x) {
+        int hl = x->child[0]->height;
+        int hr = x->child[1]->height;
+        if(hr>hl+1) avl_rotate(x,0);
+        else if(hl>hr+1) avl_rotate(x,1);
+        else relax(x);
+    }
+
+    /**
+     * given a node x in a subtree rooted at r
+     * where there is an avl or augmentation violation
+     * avl_fix_tree(x,r) rebalances the path from x up to r
+     * and brings the subtree back to a valid AVL state
+     */
+    void avl_fix_tree(node* x,node* r) {
+        while(x!=nill && x!=r->parent) {
+            avl_rebalance(x);
+            x=x->parent;
+        }
+    }
+
+    /**
+     * takes z out of the AVL tree and rebalances, without freeing it
+     * z can't be NILL
+     */
+    void avl_unlink(node* z) {
+        if(z->child[0]==nill) {
+            transplant(z,z->child[1]);
+            avl_fix_tree(z->parent,root);
+        } else if(z->child[1]==nill) {
+            transplant(z,z->child[0]);
+            avl_fix_tree(z->parent,root);
+        } else {
+            // the successor of z, it has no left child
+            node* y = z->child[1];
+            while(y->child[0]!=nill) y = y->child[0];
+            if(y->parent!=z) {
+                transplant(y,y->child[1]);
+                avl_fix_tree(y->parent,z);
+
+                y->child[1] = z->child[1];
+                y->child[1]->parent = y;
+            }
+
+            transplant(z,y);
+            y->child[0] = z->child[0];
+            y->child[0]->parent = y;
+
+            avl_fix_tree(y,root);
+        }
+    }
+
+    /**
+     * traverses from node y to root and relaxes augmentation values on all nodes on the path
+     */
+    void fix_augmentation(node* y) {
+        while(y!=root) {
+            relax(y);
+            y=y->parent;
+        }
+
+        relax(root);
+    }
+
+    /**
+     * recolors, rebalances and fixes augmentation
+     * after z was hung into the tree as a red leaf
+     */
+    void rb_insert_fixup(node* z) {
+        while(z->parent->color==red) {
+            // d is the side of z's parent, the uncle is on the other side
+            int d = z->parent==z->parent->parent->child[1];
+            node* uncle = z->parent->parent->child[!d];
+            if(uncle->color==red) {
+                z->parent->parent->color = red;
+                uncle->color = black;
+                z->parent->color = black;
+
+                relax(z->parent);
+                relax(z->parent->parent);
+
+                z = z->parent->parent;
+            } else {
+                if(z==z->parent->child[!d]) {
+                    z = z->parent;
+                    single_rotate(z,d);
+                }
+                z->parent->color = black;
+                z->parent->parent->color = red;
+                relax(z->parent->parent);
+                single_rotate(z->parent->parent,!d);
+            }
+        }
+
+        fix_augmentation(z);
+        root->color = black;
+    }
+
+    /**
+     * takes z out of the red-black tree and restores the red-black
+     * properties and the augmentation, without freeing it
+     * z can't be NILL
+     */
+    void rb_unlink(node* z) {
+        node* y = z;
+        rb_color y_original_color = y->color;
+        // x takes the place of y, its parent is set even if it is NILL,
+        // the fixup starts from there
+        node* x;
+        if(z->child[0]==nill || z->child[1]==nill) {
+            x = z->child[z->child[0]==nill];
+            transplant(z,x);
+            x->parent = z->parent;
+        } else {
+            // the successor of z, it has no left child
+            y = z->child[1];
+            while(y->child[0]!=nill) y = y->child[0];
+            y_original_color = y->color;
+            x = y->child[1];
+            if(y->parent==z) {
+                x->parent = y;
+            } else {
+                transplant(y,x);
+                x->parent = y->parent;
+                y->child[1] = z->child[1];
+                y->child[1]->parent = y;
+            }
+
+            transplant(z,y);
+            y->child[0] = z->child[0];
+            y->child[0]->parent = y;
+            y->color = z->color;
+        }
+
+        if(y_original_color==black) {
+            rb_delete_fixup(x);
+        } else {
+            fix_augmentation(x);
+        }
+    }
+
+    /**
+     * recolors, rebalances and fixes augmentation after a black node was
+     * taken out above x, x (possibly NILL, with its parent set) is doubly black
+     */
+    void rb_delete_fixup(node* x) {
+        node* fixer = x;
+        /**
+         * loop invariants :
+         * all children of x has the correct augmentation
+         * x is doubly black
+         * x is not root
+         */
+        while(x!=root && x->color==black) {
+            // d is the side of x, its brother is on the other side
+            // x may be NILL but then its brother is not, so d is right
+            int d = x==x->parent->child[1];
+            node* brother = x->parent->child[!d];
+            if(brother->color==red) {
+                brother->color = black;
+                x->parent->color = red;
+                single_rotate(x->parent,d);
+                brother = x->parent->child[!d];
+            }
+
+            //bro is now black
+            if(brother->child[0]->color==black && brother->child[1]->color==black) {
+                brother->color = red;
+                relax(x);
+                x = x->parent;
+            } else {
+                if(brother->child[!d]->color==black) {
+                    brother->child[d]->color = black;
+                    brother->color = red;
+                    single_rotate(brother,!d);
+                    brother = x->parent->child[!d];
+                }
+
+                brother->color = x->parent->color;
+                x->parent->color = black;
+                brother->child[!d]->color = black;
+                single_rotate(x->parent,d);
+                fixer = x;
+                x = root;
+            }
+        }
+
+        fix_augmentation(fixer);
+        x->color = black;
+    }
+
+    /**
+     * Does a Single splay Rotation of x towards the ancestor goal (NILL for the root)
+     * dx is the side of x below its parent, dp the side of the parent
+     */
+    void single_splay(node* x,node* goal) {
+        node* p = x->parent;
+        int dx = x==p->child[1];
+        if(p->parent==goal) {
+            single_rotate(p,!dx);
+        } else {
+            node* grandfather = p->parent;
+            int dp = p==grandfather->child[1];
+            relax(p);
+            if(dx==dp) {
+                // zig-zig
+                single_rotate(grandfather,!dp);
+                single_rotate(p,!dx);
+            } else {
+                // zig-zag
+                single_rotate(p,!dx);
+                single_rotate(grandfather,!dp);
+            }
+        }
+    }
+
+    /**
+     * splays x until its parent is goal, goal NILL splays it to the root
+     */
+    void splay(node* x,node* goal) {
+        while(x->parent!=goal) {
+            single_splay(x,goal);
+        }
+    }
+
+    /**
+     * Semi-splay of x
+     * zig-zag steps are the same as in splay
+     * a zig-zig step only rotates the parent over the grandparent
+     * and continues from the parent, so x ends up at about half of
+     * its original depth instead of at the root
+     */
+    void semi_splay(node* x) {
+        while(x->parent!=nill) {
+            node* p = x->parent;
+            node* g = p->parent;
+            int dx = x==p->child[1];
+            if(g==nill) {
+                single_rotate(p,!dx);
+                return;
+            }
+
+            if((p==g->child[1])==dx) {
+                single_rotate(g,!dx);
+                x = p;
+            } else {
+                single_splay(x,nill);
+            }
+        }
+    }
+};
+
+/**
+ * the balancer of the tree with root root and sentinel nill, relax is its
+ * augmentation hook, rotations (if not null) counts the rotations
+ */
+template<class node,class Relax>
+balancer<node,Relax> make_balancer(node*& root,node* nill,Relax relax,unsigned long long* rotations = nullptr) {
+    return {root,nill,relax,rotations};
+}
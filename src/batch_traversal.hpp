@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * Helpers shared by the tree headers for batched rank queries.
+ * A sorted batch of k queries is pushed down the tree in one traversal:
+ * at every node the batch is split into the part that continues left,
+ * the part answered by the node and the part that continues right, so a
+ * node is visited once no matter how many queries pass through it.
+ * That is O(k log(n/k)) nodes instead of O(k log n) for k separate descents,
+ * and nothing is restructured (no splaying).
+ *
+ * An explicit stack is used so that unbalanced (splay) trees can't
+ * overflow the call stack.
+ *
+ * node must have child[2] (left, right) and size fields, NILL terminated.
+ * self(x) is the number of live keys stored at x itself (0 for a tombstone).
+ */
+
+/**
+ * calls out(i,x) with x the node of rank ranks[i] for every i
+ * ranks must be sorted and 0 <= ranks[i] < root->size
+ */
+template<class node,class Self,class Out>
+void select_many_nodes(node* root,node* nill,const std::vector<int>& ranks,Self self,Out out) {
+    struct frame {
+        node* x;
+        int lo,hi,offset;
+    };
+
+    std::vector<frame> stack;
+    stack.reserve(64);
+    if(!ranks.empty()) stack.push_back({root,0,(int)ranks.size(),0});
+    const int* r = ranks.data();
+
+    while(!stack.empty()) {
+        frame f = stack.back();
+        stack.pop_back();
+
+        if(f.hi-f.lo==1) {
+            // a single rank left, a plain descent without the bookkeeping
+            node* x = f.x;
+            int k = r[f.lo]-f.offset;
+            while(true) {
+                int s = self(x);
+                if(x->child[0]->size>k) x = x->child[0];
+                else if(x->child[0]->size==k && s) break;
+                else {
+                    k -= x->child[0]->size+s;
+                    x = x->child[1];
+                }
+            }
+            out(f.lo,x);
+            continue;
+        }
+
+        int here = f.offset+f.x->child[0]->size;
+        int s = self(f.x);
+        int mid1 = std::lower_bound(r+f.lo,r+f.hi,here)-r;
+        int mid2 = std::lower_bound(r+mid1,r+f.hi,here+s)-r;
+
+        for(int i=mid1;i<mid2;i++) out(i,f.x);
+        if(f.lo<mid1 && f.x->child[0]!=nill) stack.push_back({f.x->child[0],f.lo,mid1,f.offset});
+        if(mid2<f.hi && f.x->child[1]!=nill) stack.push_back({f.x->child[1],mid2,f.hi,here+s});
+    }
+}
+
+/**
+ * calls out(i,rank) with rank the number of keys smaller than keys[i]
+ * keys must be sorted by the tree's order
+ * goes_right(x,key) must be comp(x->key,key)
+ */
+template<class node,class K,class GoesRight,class Self,class Out>
+void rank_many_nodes(node* root,node* nill,const std::vector<K>& keys,GoesRight goes_right,Self self,Out out) {
+    struct frame {
+        node* x;
+        int lo,hi,base;
+    };
+
+    std::vector<frame> stack;
+    stack.reserve(64);
+    if(!keys.empty()) stack.push_back({root,0,(int)keys.size(),0});
+
+    while(!stack.empty()) {
+        frame f = stack.back();
+        stack.pop_back();
+
+        if(f.x==nill) {
+            for(int i=f.lo;i<f.hi;i++) out(i,f.base);
+            continue;
+        }
+
+        node* x = f.x;
+        if(f.hi-f.lo==1) {
+            // a single key left, a plain descent without the bookkeeping
+            const K& key = keys[f.lo];
+            int p = f.base;
+            while(x!=nill) {
+                if(goes_right(x,key)) {
+                    p += x->child[0]->size+self(x);
+                    x = x->child[1];
+                } else {
+                    x = x->child[0];
+                }
+            }
+            out(f.lo,p);
+            continue;
+        }
+
+        int mid = std::partition_point(keys.begin()+f.lo,keys.begin()+f.hi,[&](const K& key) {
+            return !goes_right(x,key);
+        })-keys.begin();
+
+        if(f.lo<mid) stack.push_back({x->child[0],f.lo,mid,f.base});
+        if(mid<f.hi) stack.push_back({x->child[1],mid,f.hi,f.base+x->child[0]->size+self(x)});
+    }
+}
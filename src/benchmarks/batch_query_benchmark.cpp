@@ -0,0 +1,86 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Percentile style batches: k sorted ranks (and k sorted keys) queried on
+ * the same tree, select_many/rank_many against k find_by_order/order_of_key
+ * calls, for growing k
+ */
+
+template<class Tree>
+void run(const char* name, Tree& bst, int k, int num_batches, std::mt19937& gen) {
+	int n = bst.size();
+	std::vector<std::vector<int>> ranks(num_batches, std::vector<int>(k));
+	for(std::vector<int>& batch : ranks) {
+		for(int& r : batch) r = gen() % n;
+		std::sort(batch.begin(), batch.end());
+	}
+
+	long long checksum = 0;
+	std::vector<int> out;
+	auto start = std::chrono::steady_clock::now();
+	for(const std::vector<int>& batch : ranks) {
+		bst.select_many(batch, out);
+		for(int v : out) checksum += v;
+	}
+	double batched = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for(const std::vector<int>& batch : ranks) {
+		for(int r : batch) checksum -= *bst.find_by_order(r);
+	}
+	double separate = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for(const std::vector<int>& batch : ranks) {
+		bst.rank_many(batch, out);
+		for(int v : out) checksum += v;
+	}
+	double batched_rank = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for(const std::vector<int>& batch : ranks) {
+		for(int key : batch) checksum -= bst.order_of_key(key);
+	}
+	double separate_rank = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	double queries = (double)k * num_batches;
+	std::printf("%-6s k=%-5d select_many %7.1f ns/query  find_by_order %7.1f ns/query  rank_many %7.1f ns/query  order_of_key %7.1f ns/query   (checksum %lld)\n",
+		name, k, batched * 1e9 / queries, separate * 1e9 / queries,
+		batched_rank * 1e9 / queries, separate_rank * 1e9 / queries, checksum);
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int n = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_queries = argc > 3 ? std::atoi(argv[3]) : 1000000;
+
+	std::mt19937 gen(seed);
+	AVLTree<int> avl;
+	RBTree<int> rb;
+	splay_tree<int> splay;
+	for(int i = 0; i < n; i++) {
+		// keys are 0..n-1 in random order so that ranks double as keys
+		int key = (long long)i * 7919 % n;
+		avl.insert(key);
+		rb.insert(key);
+		splay.insert(key);
+	}
+
+	for(int k : {8, 128, 1024, 16384}) {
+		int num_batches = std::max(1, num_queries / k);
+		run("avl", avl, k, num_batches, gen);
+		run("rb", rb, k, num_batches, gen);
+		run("splay", splay, k, num_batches, gen);
+	}
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+#include "../wb_tree.hpp"
+#include "perf_counters.hpp"
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Branch mispredictions and time per operation on random keys, for trees
+ * small enough to stay in cache so that mispredictions, not misses,
+ * dominate. __gnu_pbds::tree is the reference with a two way branch per
+ * level. Mispredictions come from perf_event_open and are reported as n/a
+ * where hardware counters are not available (VMs, containers,
+ * perf_event_paranoid).
+ */
+
+typedef __gnu_pbds::tree<int, __gnu_pbds::null_type, std::less<int>, __gnu_pbds::rb_tree_tag,
+	__gnu_pbds::tree_order_statistics_node_update> gnu_ost;
+
+struct phase {
+	perf_counters& counter;
+	std::chrono::steady_clock::time_point begin;
+
+	phase(perf_counters& counter) : counter(counter) {
+		counter.start();
+		begin = std::chrono::steady_clock::now();
+	}
+
+	void report(const char* tree, const char* name, size_t ops, long long checksum) {
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		counter.stop();
+		double misses = counter.per_op(perf_branch_misses, ops);
+		char per_op[32] = "n/a";
+		if(misses >= 0) std::snprintf(per_op, sizeof(per_op), "%.2f", misses);
+		std::printf("%-8s %-14s %7.1f ns/op  %6s mispredicts/op   (checksum %lld)\n",
+			tree, name, seconds * 1e9 / ops, per_op, checksum);
+	}
+};
+
+template<class Tree>
+void run(const char* name, perf_counters& counter, const std::vector<int>& keys, const std::vector<int>& queries) {
+	Tree bst;
+	for(int key : keys) bst.insert(key);
+
+	long long checksum = 0;
+	phase find(counter);
+	for(int key : queries) checksum += (bst.find(key) != bst.end());
+	find.report(name, "find", queries.size(), checksum);
+
+	checksum = 0;
+	phase rank(counter);
+	for(int key : queries) checksum += bst.order_of_key(key);
+	rank.report(name, "order_of_key", queries.size(), checksum);
+
+	// tree keys are even, odd keys are inserted and erased again
+	phase update(counter);
+	for(int key : queries) {
+		bst.insert(key | 1);
+		bst.erase(key | 1);
+	}
+	update.report(name, "insert+erase", queries.size(), bst.size());
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int num_keys = argc > 2 ? std::atoi(argv[2]) : 100000;
+	int num_queries = argc > 3 ? std::atoi(argv[3]) : 2000000;
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> key_dist(0, num_keys * 4);
+	std::vector<int> keys(num_keys), queries(num_queries);
+	for(int& key : keys) key = key_dist(gen) & ~1;
+	for(int& key : queries) key = key_dist(gen);
+
+	perf_counters counter{perf_branch_misses};
+	if(!counter.available()) std::printf("no hardware branch miss counter, timing only\n");
+
+	run<gnu_ost>("gnu_ost", counter, keys, queries);
+	run<AVLTree<int>>("avl", counter, keys, queries);
+	run<RBTree<int>>("rb", counter, keys, queries);
+	run<splay_tree<int>>("splay", counter, keys, queries);
+	run<WBTree<int>>("wb", counter, keys, queries);
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+#include "../dominance_counter.hpp"
+#include "../avl_tree.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * Mixed inserts, erases and dominance counts on random points,
+ * DominanceCounter over RBTree and AVLTree against scanning a std::vector
+ */
+
+struct dominance_op {int op, x, y;};
+
+template<class Counter>
+void run(const char* name, Counter& c, const std::vector<dominance_op>& ops) {
+	long long checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(const dominance_op& o : ops) {
+		if(o.op == 0) c.insert(o.x, o.y);
+		else if(o.op == 1) c.erase(o.x, o.y);
+		else checksum += c.count(o.x, o.y);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-20s %14.0f ops/s   (checksum %lld)\n", name, ops.size() / seconds, checksum);
+}
+
+/**
+ * unordered points, erase swaps with the last one, count scans everything
+ */
+struct brute_force_dominance {
+	std::vector<std::pair<int,int>> points;
+
+	void insert(int x, int y) {
+		for(const std::pair<int,int>& p : points) if(p.first == x && p.second == y) return;
+		points.push_back(std::make_pair(x, y));
+	}
+
+	void erase(int x, int y) {
+		for(std::pair<int,int>& p : points) {
+			if(p.first == x && p.second == y) {
+				p = points.back();
+				points.pop_back();
+				return;
+			}
+		}
+	}
+
+	int count(int X, int Y) {
+		int c = 0;
+		for(const std::pair<int,int>& p : points) c += (p.first <= X && p.second <= Y);
+		return c;
+	}
+};
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int num_ops = argc > 2 ? std::atoi(argv[2]) : 200000;
+	int max_x = argc > 3 ? std::atoi(argv[3]) : 100000;
+
+	std::mt19937 gen(seed);
+	std::vector<dominance_op> ops(num_ops);
+	std::vector<std::pair<int,int>> inserted;
+	for(dominance_op& o : ops) {
+		int r = gen() % 4;
+		o.op = r < 2 ? 0 : r - 1; // half inserts, a quarter erases, a quarter counts
+		o.x = gen() % (max_x + 1);
+		o.y = gen() % 1000000;
+		if(o.op == 0) inserted.push_back(std::make_pair(o.x, o.y));
+		else if(o.op == 1 && !inserted.empty()) {
+			// erase a point inserted earlier so that the set does not only grow
+			std::pair<int,int> p = inserted[gen() % inserted.size()];
+			o.x = p.first;
+			o.y = p.second;
+		}
+	}
+
+	DominanceCounter<RBTree> rb(max_x);
+	run("DominanceCounter<RB>", rb, ops);
+
+	DominanceCounter<AVLTree> avl(max_x);
+	run("DominanceCounter<AVL>", avl, ops);
+
+	brute_force_dominance brute;
+	run("brute force", brute, ops);
+
+	return 0;
+}
@@ -0,0 +1,158 @@
+#include "../flat_combining_tree.hpp"
+#include "../rb_tree.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Throughput of an RBTree shared by 1 to max_threads threads on a write
+ * heavy mix (40% insert, 40% erase, 20% order_of_key, the size stays
+ * around the initial one) behind
+ * - a std::mutex
+ * - a std::shared_timed_mutex, order_of_key takes it shared
+ *   (std::shared_mutex is C++17, the benchmarks are C++14)
+ * - flat_combining_tree
+ * The same number of operations is spread over the threads in every run.
+ *
+ * usage: flat_combining_benchmark [seed] [max_threads] [operations] [initial_size]
+ */
+
+struct mutex_tree {
+	RBTree<int> tree;
+	std::mutex m;
+
+	long long insert(int key) {
+		std::lock_guard<std::mutex> lock(m);
+		return tree.insert(key).second;
+	}
+
+	long long erase(int key) {
+		std::lock_guard<std::mutex> lock(m);
+		return tree.erase(key);
+	}
+
+	long long order_of_key(int key) {
+		std::lock_guard<std::mutex> lock(m);
+		return tree.order_of_key(key);
+	}
+};
+
+struct shared_mutex_tree {
+	RBTree<int> tree;
+	std::shared_timed_mutex m;
+
+	long long insert(int key) {
+		std::unique_lock<std::shared_timed_mutex> lock(m);
+		return tree.insert(key).second;
+	}
+
+	long long erase(int key) {
+		std::unique_lock<std::shared_timed_mutex> lock(m);
+		return tree.erase(key);
+	}
+
+	long long order_of_key(int key) {
+		std::shared_lock<std::shared_timed_mutex> lock(m);
+		return tree.order_of_key(key);
+	}
+};
+
+struct combining_tree {
+	flat_combining_tree<int> tree;
+
+	long long insert(int key) {
+		return tree.insert(key).second;
+	}
+
+	long long erase(int key) {
+		return tree.erase(key);
+	}
+
+	long long order_of_key(int key) {
+		return tree.order_of_key(key);
+	}
+};
+
+template<class Shared>
+double run(Shared& shared, int num_threads, int operations, int key_range, int seed, long long& checksum) {
+	std::atomic<bool> go(false);
+	std::atomic<long long> sum(0);
+	std::vector<std::thread> threads;
+
+	for(int t = 0; t < num_threads; t++) {
+		int ops = operations / num_threads + (t < operations % num_threads);
+		threads.emplace_back([&, t, ops]() {
+			std::mt19937 gen(seed * 1000 + t);
+			std::uniform_int_distribution<int> key_dist(0, key_range - 1);
+			long long local = 0;
+			while(!go.load()) std::this_thread::yield();
+
+			for(int i = 0; i < ops; i++) {
+				int key = key_dist(gen);
+				int kind = gen() % 5;
+				if(kind < 2) local += shared.insert(key);
+				else if(kind < 4) local += shared.erase(key);
+				else local += shared.order_of_key(key);
+			}
+			sum += local;
+		});
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	go = true;
+	for(std::thread& t : threads) t.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	checksum += sum;
+	return operations / seconds;
+}
+
+template<class Shared, class Fill>
+void compare(const char* name, int max_threads, int operations, int initial_size, int seed, Fill fill) {
+	for(int threads = 1; threads <= max_threads; threads *= 2) {
+		Shared shared;
+		fill(shared);
+		long long checksum = 0;
+		double ops_per_second = run(shared, threads, operations, 2 * initial_size, seed, checksum);
+		std::printf("%-14s %3d threads %12.0f ops/s", name, threads, ops_per_second);
+		print_extra(shared);
+		std::printf("   (checksum %lld)\n", checksum);
+	}
+}
+
+template<class Shared>
+void print_extra(Shared&) {}
+
+void print_extra(combining_tree& shared) {
+	unsigned long long batches = shared.tree.batches();
+	if(batches > 0) std::printf("   %5.1f requests/batch", (double)shared.tree.combined_requests() / batches);
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int max_threads = argc > 2 ? std::atoi(argv[2]) : 64;
+	int operations = argc > 3 ? std::atoi(argv[3]) : 400000;
+	int initial_size = argc > 4 ? std::atoi(argv[4]) : 100000;
+
+	std::mt19937 gen(seed);
+	std::vector<int> initial(initial_size);
+	for(int& key : initial) key = gen() % (2 * initial_size);
+
+	compare<mutex_tree>("mutex", max_threads, operations, initial_size, seed, [&](mutex_tree& s) {
+		for(int key : initial) s.tree.insert(key);
+	});
+	compare<shared_mutex_tree>("shared_mutex", max_threads, operations, initial_size, seed, [&](shared_mutex_tree& s) {
+		for(int key : initial) s.tree.insert(key);
+	});
+	compare<combining_tree>("flat_combining", max_threads, operations, initial_size, seed, [&](combining_tree& s) {
+		for(int key : initial) s.tree.underlying().insert(key);
+	});
+
+	return 0;
+}
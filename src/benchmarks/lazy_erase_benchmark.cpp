@@ -0,0 +1,65 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+
+/**
+ * Queue-like churn: every step inserts a new random key and erases the
+ * oldest live one, with an order_of_key query in between
+ * compares eager erase against lazy erase at different rebuild thresholds
+ */
+
+template<class Tree>
+void run(const char* name, bool lazy, double max_dead, int window, int num_ops, int seed) {
+	Tree bst;
+	bst.set_lazy_erase(lazy, max_dead);
+
+	std::mt19937 gen(seed);
+	std::deque<int> fifo;
+	for(int i = 0; i < window; i++) {
+		int key = gen();
+		bst.insert(key);
+		fifo.push_back(key);
+	}
+
+	long long checksum = 0;
+	double erase_seconds = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < num_ops; i++) {
+		int key = gen();
+		bst.insert(key);
+		fifo.push_back(key);
+		checksum += bst.order_of_key(gen());
+
+		auto erase_start = std::chrono::steady_clock::now();
+		auto it = bst.find(fifo.front());
+		if(it != bst.end()) bst.erase(it);
+		erase_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - erase_start).count();
+		fifo.pop_front();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	char mode[32] = "eager";
+	if(lazy) std::snprintf(mode, sizeof(mode), "lazy(%.2f)", max_dead);
+	std::printf("%-4s %-12s %12.0f steps/s %10.1f ns/erase   (checksum %lld)\n", name, mode,
+		num_ops / seconds, erase_seconds * 1e9 / num_ops, checksum);
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int window = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_ops = argc > 3 ? std::atoi(argv[3]) : 2000000;
+
+	for(double max_dead : {0.0, 0.25, 0.5}) {
+		run<AVLTree<int>>("avl", max_dead > 0, max_dead, window, num_ops, seed);
+	}
+	for(double max_dead : {0.0, 0.25, 0.5}) {
+		run<RBTree<int>>("rb", max_dead > 0, max_dead, window, num_ops, seed);
+	}
+
+	return 0;
+}
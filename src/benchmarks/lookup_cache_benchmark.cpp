@@ -0,0 +1,78 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Skewed lookups: find and order_of_key on keys drawn from a Zipf(1)
+ * distribution, with an update (erase and reinsert of a random key) every
+ * write_every lookups, with and without the lookup cache
+ */
+
+template<class Tree>
+void run(const char* name, Tree& bst, std::size_t slots, const std::vector<int>& queries,
+		const std::vector<int>& updates, int write_every) {
+	bst.enable_lookup_cache(slots);
+
+	long long checksum = 0;
+	std::size_t next_update = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(std::size_t i = 0; i < queries.size(); i++) {
+		if(write_every > 0 && i % write_every == 0) {
+			int key = updates[next_update++ % updates.size()];
+			bst.erase(key);
+			bst.insert(key);
+		}
+		if(i & 1) checksum += bst.order_of_key(queries[i]);
+		else checksum += *bst.find(queries[i]);
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	double lookups = bst.lookup_cache_hits() + bst.lookup_cache_misses();
+	std::printf("%-4s slots=%-6zu write_every=%-6d %7.1f ns/lookup  hit rate %5.1f%%   (checksum %lld)\n",
+		name, slots, write_every, elapsed * 1e9 / queries.size(),
+		lookups > 0 ? 100.0 * bst.lookup_cache_hits() / lookups : 0.0, checksum);
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int n = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_queries = argc > 3 ? std::atoi(argv[3]) : 5000000;
+
+	std::mt19937 gen(seed);
+	AVLTree<int> avl;
+	RBTree<int> rb;
+	std::vector<int> keys(n);
+	for(int i = 0; i < n; i++) keys[i] = i;
+	std::shuffle(keys.begin(), keys.end(), gen);
+	for(int key : keys) {
+		avl.insert(key);
+		rb.insert(key);
+	}
+
+	// rank r (0 based) of the popularity order is drawn with probability ~ 1/(r+1)
+	std::vector<double> cdf(n);
+	double total = 0;
+	for(int r = 0; r < n; r++) cdf[r] = total += 1.0 / (r + 1);
+	std::uniform_real_distribution<double> u(0, total);
+	std::vector<int> queries(num_queries);
+	for(int& q : queries) q = keys[std::lower_bound(cdf.begin(), cdf.end(), u(gen)) - cdf.begin()];
+
+	std::vector<int> updates(1 << 16);
+	for(int& key : updates) key = gen() % n;
+
+	for(int write_every : {0, 10000, 100}) {
+		for(std::size_t slots : {(std::size_t)0, (std::size_t)1024, (std::size_t)65536}) {
+			run("avl", avl, slots, queries, updates, write_every);
+			run("rb", rb, slots, queries, updates, write_every);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Miss heavy finds: 70% of the queried keys are absent, with and without
+ * the negative filter for growing memory budgets (bytes per key)
+ */
+
+template<class Tree>
+void run(const char* name, int n, int bytes_per_key, const std::vector<int>& keys, const std::vector<int>& queries) {
+	Tree bst;
+	for(int key : keys) bst.insert(key);
+	bst.enable_negative_filter((std::size_t)bytes_per_key * n);
+
+	long long checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(int q : queries) {
+		auto it = bst.find(q);
+		if(it != bst.end()) checksum += *it;
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const auto& stats = bst.negative_filter_stats();
+	std::printf("%-6s bytes/key=%-3d %7.1f ns/find  rejected %5.1f%%  false positive rate %6.3f%% (estimated %6.3f%%)   (checksum %lld)\n",
+		name, bytes_per_key, elapsed * 1e9 / queries.size(),
+		stats.queries() > 0 ? 100.0 * stats.rejected() / stats.queries() : 0.0,
+		100.0 * stats.false_positive_rate(), bytes_per_key > 0 ? 100.0 * stats.estimated_false_positive_rate() : 100.0, checksum);
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int n = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_queries = argc > 3 ? std::atoi(argv[3]) : 2000000;
+
+	std::mt19937 gen(seed);
+	// even keys are present, odd keys absent
+	std::vector<int> keys(n);
+	for(int i = 0; i < n; i++) keys[i] = 2 * i;
+	std::shuffle(keys.begin(), keys.end(), gen);
+
+	std::vector<int> queries(num_queries);
+	for(int& q : queries) q = 2 * (int)(gen() % n) + (gen() % 10 < 7 ? 1 : 0);
+
+	for(int bytes_per_key : {0, 4, 8, 16}) {
+		run<AVLTree<int>>("avl", n, bytes_per_key, keys, queries);
+		run<RBTree<int>>("rb", n, bytes_per_key, keys, queries);
+		run<splay_tree<int>>("splay", n, bytes_per_key, keys, queries);
+	}
+
+	return 0;
+}
@@ -0,0 +1,47 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../wb_tree.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+/**
+ * Full scan throughput: sequential begin()/++ loop against
+ * parallel_reduce with 1, 2, 4, ... threads up to the number of cores
+ */
+
+template<class Tree>
+void run(const char* name, int num_keys, int seed) {
+	Tree bst;
+	std::mt19937 gen(seed);
+	for(int i = 0; i < num_keys; i++) bst.insert(gen());
+
+	auto start = std::chrono::steady_clock::now();
+	long long sum = 0;
+	for(auto it = bst.begin(); it != bst.end(); ++it) sum += *it;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-6s %-12s %14.0f keys/s   (sum %lld)\n", name, "sequential", bst.size() / seconds, sum);
+
+	unsigned max_threads = std::thread::hardware_concurrency();
+	if(max_threads == 0) max_threads = 1;
+	for(unsigned threads = 1; threads <= max_threads; threads *= 2) {
+		start = std::chrono::steady_clock::now();
+		sum = bst.parallel_reduce(0LL, [](long long a, long long b) {return a + b;}, threads);
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("%-6s parallel(%2u) %14.0f keys/s   (sum %lld)\n", name, threads, bst.size() / seconds, sum);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int num_keys = argc > 2 ? std::atoi(argv[2]) : 10000000;
+
+	run<AVLTree<unsigned>>("avl", num_keys, seed);
+	run<RBTree<unsigned>>("rb", num_keys, seed);
+	run<WBTree<unsigned>>("wb", num_keys, seed);
+
+	return 0;
+}
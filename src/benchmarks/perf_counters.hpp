@@ -0,0 +1,136 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+
+/**
+ * Hardware counters for the benchmarks, read with perf_event_open around a
+ * phase and normalized per operation.
+ *
+ * Every event is opened on its own rather than as a group, so an event the
+ * CPU does not have only loses its own column, and when there are more
+ * events than counters the kernel multiplexes them and the counts are
+ * scaled by the share of the phase each was running. Where no counter can
+ * be opened (VMs, containers, perf_event_paranoid) every count is -1 and
+ * the benchmarks fall back to timing only. User space only, this thread.
+ */
+
+enum perf_event_kind {
+	perf_cycles,
+	perf_instructions,
+	perf_l1d_misses,    // L1 data cache read misses
+	perf_llc_misses,    // last level cache misses
+	perf_branch_misses,
+	perf_dtlb_misses,   // data TLB read misses
+	NUM_PERF_EVENTS
+};
+
+struct perf_counters {
+	static const char* name(int e) {
+		static const char* names[] = {"cycles", "instructions", "L1d-misses", "LLC-misses", "branch-misses", "dTLB-misses"};
+		return names[e];
+	}
+
+	int fd[NUM_PERF_EVENTS];
+	long long count[NUM_PERF_EVENTS]; // counts of the last phase, -1 if not counted
+
+	perf_counters(std::initializer_list<perf_event_kind> events = {perf_cycles, perf_instructions, perf_l1d_misses,
+		perf_llc_misses, perf_branch_misses, perf_dtlb_misses}) {
+		for(int e = 0; e < NUM_PERF_EVENTS; e++) {
+			fd[e] = -1;
+			count[e] = -1;
+		}
+		for(perf_event_kind e : events) fd[e] = open_event(e);
+	}
+
+	perf_counters(const perf_counters&) = delete;
+	perf_counters& operator=(const perf_counters&) = delete;
+
+	/**
+	 * whether at least one counter could be opened
+	 */
+	bool available() const {
+		for(int e = 0; e < NUM_PERF_EVENTS; e++) {
+			if(fd[e] >= 0) return true;
+		}
+		return false;
+	}
+
+	void start() {
+		for(int e = 0; e < NUM_PERF_EVENTS; e++) {
+			if(fd[e] < 0) continue;
+			ioctl(fd[e], PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd[e], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+
+	/**
+	 * stops counting and fills count
+	 */
+	void stop() {
+		for(int e = 0; e < NUM_PERF_EVENTS; e++) {
+			if(fd[e] >= 0) ioctl(fd[e], PERF_EVENT_IOC_DISABLE, 0);
+		}
+		for(int e = 0; e < NUM_PERF_EVENTS; e++) {
+			count[e] = -1;
+			std::uint64_t v[3]; // value, time enabled, time running
+			if(fd[e] < 0 || read(fd[e], v, sizeof(v)) != sizeof(v) || v[2] == 0) continue;
+			count[e] = v[2] == v[1] ? v[0] : (long long)((double)v[0] * v[1] / v[2]);
+		}
+	}
+
+	/**
+	 * count of e in the last phase divided by ops, -1 if not counted
+	 */
+	double per_op(perf_event_kind e, size_t ops) const {
+		return count[e] < 0 ? -1 : (double)count[e] / ops;
+	}
+
+	/**
+	 * prints "  name/op value" for every event counted in the last phase
+	 */
+	void print_per_op(size_t ops) const {
+		for(int e = 0; e < NUM_PERF_EVENTS; e++) {
+			if(count[e] >= 0) std::printf("  %s/op %.2f", name(e), (double)count[e] / ops);
+		}
+	}
+
+	~perf_counters() {
+		for(int e = 0; e < NUM_PERF_EVENTS; e++) {
+			if(fd[e] >= 0) close(fd[e]);
+		}
+	}
+
+	private:
+	static int open_event(perf_event_kind e) {
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		switch(e) {
+			case perf_cycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+			case perf_instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+			case perf_llc_misses: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+			case perf_branch_misses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+			case perf_l1d_misses:
+			case perf_dtlb_misses:
+				attr.type = PERF_TYPE_HW_CACHE;
+				attr.config = (e == perf_l1d_misses ? PERF_COUNT_HW_CACHE_L1D : PERF_COUNT_HW_CACHE_DTLB)
+					| (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+				break;
+			default: return -1;
+		}
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+	}
+};
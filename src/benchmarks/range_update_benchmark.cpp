@@ -0,0 +1,63 @@
+#include "../splay_range_sequence.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Bulk range updates (reverse, add, assign) and range sums on random
+ * ranges, splay_range_sequence against applying them element by element
+ * on a std::vector
+ */
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int n = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_ops = argc > 3 ? std::atoi(argv[3]) : 20000;
+
+	std::mt19937 gen(seed);
+	struct range_op {int op, first, last; long long val;};
+	std::vector<range_op> ops(num_ops);
+	for(range_op& r : ops) {
+		r.first = gen() % n;
+		r.last = gen() % n;
+		if(r.first > r.last) std::swap(r.first, r.last);
+		r.last++;
+		r.op = gen() % 4;
+		r.val = gen() % 1000;
+	}
+
+	splay_range_sequence<long long> seq;
+	std::vector<long long> vec;
+	for(int i = 0; i < n; i++) {
+		seq.push_back(i);
+		vec.push_back(i);
+	}
+
+	long long checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(const range_op& r : ops) {
+		if(r.op == 0) seq.reverse(r.first, r.last);
+		else if(r.op == 1) seq.add(r.first, r.last, r.val);
+		else if(r.op == 2) seq.assign(r.first, r.last, r.val);
+		else checksum += seq.sum(r.first, r.last);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-20s %14.0f ops/s   (checksum %lld)\n", "splay_range_sequence", num_ops / seconds, checksum);
+
+	checksum = 0;
+	start = std::chrono::steady_clock::now();
+	for(const range_op& r : ops) {
+		if(r.op == 0) std::reverse(vec.begin() + r.first, vec.begin() + r.last);
+		else if(r.op == 1) for(int i = r.first; i < r.last; i++) vec[i] += r.val;
+		else if(r.op == 2) std::fill(vec.begin() + r.first, vec.begin() + r.last, r.val);
+		else for(int i = r.first; i < r.last; i++) checksum += vec[i];
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-20s %14.0f ops/s   (checksum %lld)\n", "vector", num_ops / seconds, checksum);
+
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Lookup latency of a tree aged by churn (random erases and inserts, so
+ * the nodes end up scattered over the heap), of the same tree after an
+ * incremental relayout done in small steps between lookups, and after a
+ * full relayout in each policy. The freshly loaded tree, whose nodes were
+ * allocated in key order, is the baseline.
+ */
+
+double seconds_since(std::chrono::steady_clock::time_point begin) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template<class Tree>
+double find_ns(Tree& bst, const std::vector<int>& queries, long long& found) {
+	auto begin = std::chrono::steady_clock::now();
+	for(int q : queries) found += bst.find(q) != bst.end();
+	return seconds_since(begin) * 1e9 / queries.size();
+}
+
+template<class Tree>
+void run(const char* name, int n, int churn, const std::vector<int>& queries, int seed) {
+	std::mt19937 gen(seed);
+	long long found = 0;
+
+	Tree bst;
+	for(int i = 0; i < n; i++) bst.insert(4 * i);
+	double fresh = find_ns(bst, queries, found);
+
+	std::uniform_int_distribution<int> key_dist(0, 4 * n);
+	for(int i = 0; i < churn; i++) {
+		bst.erase_by_order(gen() % bst.size());
+		while((int)bst.size() < n) bst.insert(key_dist(gen) & ~1);
+	}
+	double aged = find_ns(bst, queries, found);
+
+	// the relayout runs in steps of 1024 nodes, one step per 1024 lookups
+	const int STEP = 1024;
+	auto begin = std::chrono::steady_clock::now();
+	bst.begin_relayout(van_emde_boas);
+	double plan = seconds_since(begin);
+	size_t q = 0;
+	begin = std::chrono::steady_clock::now();
+	int steps = 0;
+	bool done = false;
+	while(!done) {
+		done = bst.relayout_step(STEP);
+		steps++;
+		for(int i = 0; i < STEP; i++, q = (q + 1) % queries.size()) found += bst.find(queries[q]) != bst.end();
+	}
+	double incremental = seconds_since(begin) * 1e9 / ((double)steps * STEP);
+	double after_steps = find_ns(bst, queries, found);
+
+	begin = std::chrono::steady_clock::now();
+	bst.relayout(breadth_first);
+	double full = seconds_since(begin);
+	double bfs = find_ns(bst, queries, found);
+
+	bst.compact();
+	double veb = find_ns(bst, queries, found);
+
+	std::printf("%-6s fresh %6.1f  aged %6.1f  veb (incremental) %6.1f  bfs %6.1f  veb %6.1f ns/find\n",
+		name, fresh, aged, after_steps, bfs, veb);
+	std::printf("%-6s planning %.1f ms, %d steps at %.1f ns/(lookup + moved node), full relayout %.1f ms   (found %lld)\n",
+		name, plan * 1e3, steps, incremental, full * 1e3, found);
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int n = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_queries = argc > 3 ? std::atoi(argv[3]) : 1000000;
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> key_dist(0, 4 * n);
+	std::vector<int> queries(num_queries);
+	for(int& q : queries) q = key_dist(gen);
+
+	run<AVLTree<int>>("avl", n, 4 * n, queries, seed);
+	run<RBTree<int>>("rb", n, 4 * n, queries, seed);
+	run<splay_tree<int>>("splay", n, 4 * n, queries, seed);
+
+	return 0;
+}
@@ -0,0 +1,10 @@
+#!/bin/bash
+set -xe
+
+SEED=0
+
+for benchmark in *_benchmark.cpp; do
+	name=${benchmark%.cpp}
+	g++ -std=c++14 -O3 -o ${name}.out ${benchmark} -lpthread
+	./${name}.out $SEED
+done
@@ -0,0 +1,64 @@
+#include "../avl_sequence.hpp"
+#include "../splay_sequence.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <vector>
+
+/**
+ * Editable sequence workload: inserts at random positions, random reads,
+ * erases at random positions
+ * compares AVLSequence and splay_sequence against std::vector and std::deque
+ */
+
+template<class C>
+struct std_sequence {
+	C c;
+	void insert_at(int pos, int val) {c.insert(c.begin() + pos, val);}
+	void erase_at(int pos) {c.erase(c.begin() + pos);}
+	int& at(int pos) {return c[pos];}
+	unsigned size() {return c.size();}
+};
+
+struct phase_timer {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	void report(const char* sequence, const char* phase, size_t ops, long long checksum) {
+		auto end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		std::printf("%-14s %-10s %14.0f ops/s   (checksum %lld)\n", sequence, phase, ops / seconds, checksum);
+		start = std::chrono::steady_clock::now();
+	}
+};
+
+template<class Sequence>
+void run(const char* name, int n, int seed) {
+	Sequence seq;
+	std::mt19937 gen(seed);
+	long long checksum = 0;
+	phase_timer timer;
+
+	for(int i = 0; i < n; i++) seq.insert_at(gen() % (seq.size() + 1), i);
+	timer.report(name, "insert_at", n, seq.size());
+
+	for(int i = 0; i < n; i++) checksum += seq.at(gen() % seq.size());
+	timer.report(name, "at", n, checksum);
+
+	for(int i = 0; i < n; i++) seq.erase_at(gen() % seq.size());
+	timer.report(name, "erase_at", n, seq.size());
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int n = argc > 2 ? std::atoi(argv[2]) : 200000;
+
+	run<std_sequence<std::vector<int>>>("vector", n, seed);
+	run<std_sequence<std::deque<int>>>("deque", n, seed);
+	run<AVLSequence<int>>("avl_sequence", n, seed);
+	run<splay_sequence<int>>("splay_sequence", n, seed);
+
+	return 0;
+}
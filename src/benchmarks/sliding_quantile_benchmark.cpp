@@ -0,0 +1,81 @@
+#include "../sliding_quantile.hpp"
+#include "../rb_tree.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * Rolling p50/p99 over the last window events of many streams
+ * latencies are log-normal and rounded to integers, so duplicates are common
+ * sliding_quantile_streams against what callers do by hand: an RBTree of
+ * (value, sequence number) pairs plus a FIFO per stream
+ */
+
+struct event {unsigned stream; int value;};
+
+struct rb_window {
+	RBTree<std::pair<int,long long>> tree;
+	std::deque<std::pair<int,long long>> fifo;
+};
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int num_streams = argc > 2 ? std::atoi(argv[2]) : 1000;
+	int window = argc > 3 ? std::atoi(argv[3]) : 1000;
+	int num_events = argc > 4 ? std::atoi(argv[4]) : 5000000;
+	int query_every = 100;
+
+	std::mt19937 gen(seed);
+	std::lognormal_distribution<double> latency(3.0, 0.8);
+	std::vector<event> events(num_events);
+	for(event& e : events) {
+		e.stream = gen() % num_streams;
+		e.value = (int)std::lround(latency(gen));
+	}
+
+	long long checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	{
+		sliding_quantile_streams<int> streams(window);
+		for(int i = 0; i < num_events; i++) {
+			streams.push(events[i].stream, events[i].value);
+			if(i % query_every == 0) {
+				checksum += streams.quantile(events[i].stream, 0.5) + streams.quantile(events[i].stream, 0.99);
+			}
+		}
+		std::printf("pool: %d nodes in use, %d reserved for %d streams\n", streams.node_pool().nodes_in_use(),
+			streams.node_pool().nodes_reserved(), num_streams);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-24s %14.0f events/s   (checksum %lld)\n", "sliding_quantile", num_events / seconds, checksum);
+
+	checksum = 0;
+	start = std::chrono::steady_clock::now();
+	{
+		std::vector<rb_window> windows(num_streams);
+		for(int i = 0; i < num_events; i++) {
+			rb_window& w = windows[events[i].stream];
+			std::pair<int,long long> p(events[i].value, i);
+			w.tree.insert(p);
+			w.fifo.push_back(p);
+			if((int)w.fifo.size() > window) {
+				w.tree.erase(w.fifo.front());
+				w.fifo.pop_front();
+			}
+			if(i % query_every == 0) {
+				int n = w.tree.size();
+				checksum += (*w.tree.find_by_order((int)(0.5 * (n - 1)))).first + (*w.tree.find_by_order((int)(0.99 * (n - 1)))).first;
+			}
+		}
+	}
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%-24s %14.0f events/s   (checksum %lld)\n", "RBTree + FIFO", num_events / seconds, checksum);
+
+	return 0;
+}
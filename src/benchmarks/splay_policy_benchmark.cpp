@@ -0,0 +1,81 @@
+#include "../splay_tree.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Read-heavy workload on splay_tree under every splay policy
+ * 95% reads (find, order_of_key, find_by_order) on a skewed key set
+ * 5% writes (insert, erase)
+ * reports throughput and rotations per operation
+ */
+
+typedef splay_tree<int> tree_t;
+
+struct policy_config {
+	const char* name;
+	tree_t::splay_policy policy;
+	int depth_threshold;
+	double probability;
+};
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int num_keys = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_ops = argc > 3 ? std::atoi(argv[3]) : 5000000;
+
+	std::vector<policy_config> configs = {
+		{"full", tree_t::full, 0, 1.0},
+		{"semi", tree_t::semi, 0, 1.0},
+		{"depth>24", tree_t::depth_threshold, 24, 1.0},
+		{"depth>32", tree_t::depth_threshold, 32, 1.0},
+		{"random(0.1)", tree_t::randomized, 0, 0.1},
+		{"random(0.01)", tree_t::randomized, 0, 0.01},
+	};
+
+	std::printf("%-14s %14s %14s\n", "policy", "ops/s", "rotations/op");
+	for(const policy_config& c : configs) {
+		std::mt19937 gen(seed);
+		std::uniform_int_distribution<int> key_dist(0, num_keys * 4);
+		std::uniform_int_distribution<int> op_dist(0, 99);
+		// 90% of the reads hit the 10% hottest part of the key space
+		std::uniform_int_distribution<int> hot_dist(0, num_keys * 4 / 10);
+
+		tree_t bst;
+		bst.set_splay_policy(c.policy);
+		bst.set_splay_depth_threshold(c.depth_threshold);
+		bst.set_splay_probability(c.probability, seed);
+
+		for(int i = 0; i < num_keys; i++) bst.insert(key_dist(gen));
+		unsigned long long rotations_before = bst.rotations();
+
+		long long checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for(int i = 0; i < num_ops; i++) {
+			int op = op_dist(gen);
+			int key = (op_dist(gen) < 90) ? hot_dist(gen) : key_dist(gen);
+			if(op < 2) {
+				bst.insert(key);
+			} else if(op < 5) {
+				auto it = bst.find(key);
+				if(it != bst.end()) bst.erase(it);
+			} else if(op < 65) {
+				checksum += (bst.find(key) != bst.end());
+			} else if(op < 85) {
+				checksum += bst.order_of_key(key);
+			} else if(bst.size() > 0) {
+				checksum += *bst.find_by_order(key % bst.size());
+			}
+		}
+		auto end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - start).count();
+
+		std::printf("%-14s %14.0f %14.3f   (checksum %lld)\n", c.name, num_ops / seconds,
+			double(bst.rotations() - rotations_before) / num_ops, checksum);
+	}
+
+	return 0;
+}
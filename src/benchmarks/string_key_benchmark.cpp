@@ -0,0 +1,91 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * URL like std::string keys: find with the inline key prefixes (std::less)
+ * against the same trees with an equivalent comparator the prefixes are
+ * not enabled for. A full key comparison reads the string's heap buffer,
+ * so full comparisons per lookup count the extra cache misses per level.
+ */
+
+long long full_comparisons = 0;
+
+/**
+ * counts its calls, counting_prefixed_less also gets the inline prefixes
+ */
+struct counting_less {
+	bool operator()(const std::string& a, const std::string& b) const {
+		full_comparisons++;
+		return a < b;
+	}
+};
+
+struct counting_prefixed_less : counting_less {};
+
+template<>
+struct key_prefix<std::string, counting_prefixed_less> : string_key_prefix {};
+
+std::string random_word(std::mt19937& gen, int min_len, int max_len) {
+	int len = min_len + gen() % (max_len - min_len + 1);
+	std::string w;
+	for(int i = 0; i < len; i++) w += (char)('a' + gen() % 26);
+	return w;
+}
+
+template<class Tree>
+void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string>& queries) {
+	Tree bst;
+	for(const std::string& key : keys) bst.insert(key);
+
+	full_comparisons = 0;
+	long long found = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(const std::string& q : queries) found += bst.find(q) != bst.end();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%-22s %7.1f ns/find  %5.2f full key comparisons/find   (found %lld)\n",
+		name, elapsed * 1e9 / queries.size(), (double)full_comparisons / queries.size(), found);
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int n = argc > 2 ? std::atoi(argv[2]) : 200000;
+	int num_queries = argc > 3 ? std::atoi(argv[3]) : 1000000;
+
+	std::mt19937 gen(seed);
+	std::vector<std::string> hosts;
+	for(int i = 0; i < 5000; i++) {
+		std::string host = (gen() % 2 ? "www." : "") + random_word(gen, 3, 12) + (gen() % 3 ? ".com" : ".org");
+		hosts.push_back(host);
+	}
+
+	std::vector<std::string> keys(n);
+	for(std::string& key : keys) {
+		key = "https://" + hosts[gen() % hosts.size()];
+		int segments = 1 + gen() % 3;
+		for(int s = 0; s < segments; s++) key += "/" + random_word(gen, 2, 10);
+	}
+
+	// half of the queries hit
+	std::vector<std::string> queries(num_queries);
+	for(std::string& q : queries) {
+		q = keys[gen() % n];
+		if(gen() % 2) q += "/x";
+	}
+
+	run<AVLTree<std::string, counting_less>>("avl", keys, queries);
+	run<AVLTree<std::string, counting_prefixed_less>>("avl prefix", keys, queries);
+	run<RBTree<std::string, counting_less>>("rb", keys, queries);
+	run<RBTree<std::string, counting_prefixed_less>>("rb prefix", keys, queries);
+	run<RBTree<std::string>>("rb std::less prefix", keys, queries);
+
+	return 0;
+}
@@ -0,0 +1,202 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+#include "../trace.hpp"
+#include "perf_counters.hpp"
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Replays a trace of int keys (trace.hpp) against AVLTree, RBTree,
+ * splay_tree and __gnu_pbds::tree, each starting empty. The first pass
+ * measures throughput and hardware counters per operation where they are
+ * available, the second times every operation and reports the
+ * latency distribution per kind of operation. The trace is streamed from
+ * its mapping twice per tree and never loaded.
+ *
+ * usage: trace_replay_benchmark [seed] [trace_file]
+ * Without a trace file a synthetic one is recorded first (recording_tree
+ * around an AVLTree): skewed keys, mostly lookups, and removed again.
+ */
+
+typedef __gnu_pbds::tree<int, __gnu_pbds::null_type, std::less<int>, __gnu_pbds::rb_tree_tag,
+	__gnu_pbds::tree_order_statistics_node_update> gnu_ost;
+
+/**
+ * erase_by_order answered with the plain pbds calls
+ */
+struct gnu_ost_tree : gnu_ost {
+	bool erase_by_order(int k) {
+		if(k < 0 || k >= (int)size()) return false;
+		erase(find_by_order(k));
+		return true;
+	}
+};
+
+const char* op_names[] = {"insert", "erase", "find", "order_of_key", "find_by_order", "erase_by_order"};
+const int NUM_OPS = 6;
+
+/**
+ * log-linear histogram of latencies in ns, 16 buckets per power of two,
+ * so percentiles are within about 6%
+ */
+struct latency_histogram {
+	static const int SUB = 16;
+	std::vector<long long> buckets = std::vector<long long>(64 * SUB);
+	long long count = 0;
+	long long max = 0;
+
+	static int bucket(long long ns) {
+		if(ns < SUB) return ns;
+		int e = 63 - __builtin_clzll(ns);
+		return (e - 3) * SUB + (int)((ns >> (e - 4)) & (SUB - 1));
+	}
+
+	static long long lower_bound(int b) {
+		if(b < SUB) return b;
+		int e = b / SUB + 3;
+		return (1LL << e) + ((long long)(b % SUB) << (e - 4));
+	}
+
+	void add(long long ns) {
+		buckets[bucket(ns)]++;
+		count++;
+		if(ns > max) max = ns;
+	}
+
+	long long percentile(double p) {
+		long long rank = (long long)std::ceil(p * count);
+		long long seen = 0;
+		for(int b = 0; b < (int)buckets.size(); b++) {
+			seen += buckets[b];
+			if(seen >= rank && seen > 0) return lower_bound(b);
+		}
+		return max;
+	}
+};
+
+template<class Tree>
+inline long long apply(Tree& bst, const trace_record<int>& r) {
+	switch(r.op) {
+		case trace_insert: bst.insert(r.key); return 1;
+		case trace_erase: return bst.erase(r.key);
+		case trace_find: return bst.find(r.key) != bst.end();
+		case trace_order_of_key: return bst.order_of_key(r.key);
+		case trace_find_by_order: return bst.find_by_order(r.rank) != bst.end();
+		case trace_erase_by_order: return bst.erase_by_order(r.rank);
+	}
+	return 0;
+}
+
+template<class Tree>
+void replay(const char* name, trace_reader<int>& trace, perf_counters& counters) {
+	trace_record<int> r;
+	long long checksum = 0;
+
+	{
+		Tree bst;
+		trace.rewind();
+		counters.start();
+		auto begin = std::chrono::steady_clock::now();
+		while(trace.next(r)) checksum += apply(bst, r);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		counters.stop();
+		std::printf("%-8s %12.0f ops/s   (checksum %lld)", name, trace.size() / seconds, checksum);
+		counters.print_per_op(trace.size());
+		std::printf("\n");
+	}
+
+	Tree bst;
+	latency_histogram all, by_op[NUM_OPS];
+	trace.rewind();
+	while(trace.next(r)) {
+		auto begin = std::chrono::steady_clock::now();
+		checksum += apply(bst, r);
+		long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+		all.add(ns);
+		if(r.op < NUM_OPS) by_op[r.op].add(ns);
+	}
+
+	std::printf("  %-16s %10s %7s %7s %7s %7s %9s   (ns)\n", "", "count", "p50", "p90", "p99", "p99.9", "max");
+	for(int op = 0; op <= NUM_OPS; op++) {
+		latency_histogram& h = op < NUM_OPS ? by_op[op] : all;
+		if(h.count == 0) continue;
+		std::printf("  %-16s %10lld %7lld %7lld %7lld %7lld %9lld\n", op < NUM_OPS ? op_names[op] : "all",
+			h.count, h.percentile(0.5), h.percentile(0.9), h.percentile(0.99), h.percentile(0.999), h.max);
+	}
+}
+
+/**
+ * n operations on keys drawn from a power law over [0, universe), so a few
+ * keys are hot: inserts grow the tree, 80% of the rest are lookups
+ */
+bool record_synthetic(const char* path, int seed, int n) {
+	recording_tree<AVLTree<int>> bst;
+	if(!bst.record_to(path)) return false;
+
+	std::mt19937 gen(seed);
+	const int universe = 1 << 22;
+	std::uniform_real_distribution<double> u(0, 1);
+	auto key = [&]() {return (int)(std::pow(u(gen), 3) * universe) * 2654435761u % universe;};
+
+	for(int i = 0; i < n / 4; i++) bst.insert(key());
+	while((int)bst.recorded() < n) {
+		int kind = gen() % 20;
+		if(kind < 3) bst.insert(key());
+		else if(kind < 4) bst.erase(key());
+		else if(kind < 10) bst.find(key());
+		else if(kind < 14) bst.order_of_key(key());
+		else if(kind < 19) bst.find_by_order(gen() % (bst.size() + 1));
+		else bst.erase_by_order(gen() % (bst.size() + 1));
+	}
+	return bst.stop_recording();
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	std::string path = argc > 2 ? argv[2] : "";
+	bool synthetic = path.empty();
+
+	if(synthetic) {
+		path = "trace_replay_benchmark.trace";
+		if(!record_synthetic(path.c_str(), seed, 1000000)) {
+			std::printf("could not write %s\n", path.c_str());
+			return 1;
+		}
+	}
+
+	trace_reader<int> trace;
+	if(!trace.open(path.c_str())) {
+		std::printf("%s is not a trace of int keys\n", path.c_str());
+		return 1;
+	}
+
+	// what a timed operation costs with nothing to time
+	latency_histogram overhead;
+	for(int i = 0; i < 100000; i++) {
+		auto begin = std::chrono::steady_clock::now();
+		overhead.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+	}
+	std::printf("%llu operations, timer overhead about %lld ns (p50)\n",
+		(unsigned long long)trace.size(), overhead.percentile(0.5));
+	perf_counters counters;
+	if(!counters.available()) std::printf("no hardware counters, throughput timing only\n");
+
+	replay<gnu_ost_tree>("gnu_ost", trace, counters);
+	replay<AVLTree<int>>("avl", trace, counters);
+	replay<RBTree<int>>("rb", trace, counters);
+	replay<splay_tree<int>>("splay", trace, counters);
+
+	trace.close();
+	if(synthetic) unlink(path.c_str());
+	return 0;
+}
@@ -0,0 +1,100 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+#include "../wb_tree.hpp"
+#include "perf_counters.hpp"
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+/**
+ * Compares all tree engines (and __gnu_pbds::tree as a reference)
+ * phase by phase on the same random keys:
+ * insert, find, order_of_key, find_by_order, erase
+ * Each phase also reports hardware counters per operation (perf_counters.hpp)
+ * where they are available.
+ */
+
+typedef __gnu_pbds::tree<int, __gnu_pbds::null_type, std::less<int>, __gnu_pbds::rb_tree_tag,
+	__gnu_pbds::tree_order_statistics_node_update> gnu_ost;
+
+struct phase_timer {
+	perf_counters& counters;
+	std::chrono::steady_clock::time_point start;
+
+	phase_timer(perf_counters& counters) : counters(counters) {
+		restart();
+	}
+
+	void restart() {
+		counters.start();
+		start = std::chrono::steady_clock::now();
+	}
+
+	void report(const char* tree, const char* phase, size_t ops, long long checksum) {
+		auto end = std::chrono::steady_clock::now();
+		counters.stop();
+		double seconds = std::chrono::duration<double>(end - start).count();
+		std::printf("%-8s %-14s %14.0f ops/s   (checksum %lld)", tree, phase, ops / seconds, checksum);
+		counters.print_per_op(ops);
+		std::printf("\n");
+		restart();
+	}
+};
+
+template<class Tree>
+void run(const char* name, perf_counters& counters, const std::vector<int>& keys, const std::vector<int>& queries) {
+	Tree bst;
+	long long checksum = 0;
+	phase_timer timer(counters);
+
+	for(int key : keys) bst.insert(key);
+	timer.report(name, "insert", keys.size(), bst.size());
+
+	for(int key : queries) checksum += (bst.find(key) != bst.end());
+	timer.report(name, "find", queries.size(), checksum);
+
+	checksum = 0;
+	for(int key : queries) checksum += bst.order_of_key(key);
+	timer.report(name, "order_of_key", queries.size(), checksum);
+
+	checksum = 0;
+	unsigned n = bst.size();
+	for(int key : queries) checksum += *bst.find_by_order(unsigned(key) % n);
+	timer.report(name, "find_by_order", queries.size(), checksum);
+
+	for(int key : keys) {
+		auto it = bst.find(key);
+		if(it != bst.end()) bst.erase(it);
+	}
+	timer.report(name, "erase", keys.size(), bst.size());
+}
+
+int main(int argc, char* argv[]) {
+	int seed = argc > 1 ? std::atoi(argv[1]) : 0;
+	int num_keys = argc > 2 ? std::atoi(argv[2]) : 1000000;
+	int num_queries = argc > 3 ? std::atoi(argv[3]) : 1000000;
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> key_dist(0, num_keys * 4);
+	std::vector<int> keys(num_keys), queries(num_queries);
+	for(int& key : keys) key = key_dist(gen);
+	for(int& key : queries) key = key_dist(gen);
+
+	perf_counters counters;
+	if(!counters.available()) std::printf("no hardware counters, timing only\n");
+
+	run<gnu_ost>("gnu_ost", counters, keys, queries);
+	run<AVLTree<int>>("avl", counters, keys, queries);
+	run<RBTree<int>>("rb", counters, keys, queries);
+	run<splay_tree<int>>("splay", counters, keys, queries);
+	run<WBTree<int>>("wb", counters, keys, queries);
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "rb_tree.hpp"
+
+/**
+ * Dominance Counter Class
+ * A dynamic set of 2D points (x,y) answering
+ * "how many points have x <= X and y <= Y".
+ * Can't insert the same point more than once
+ *
+ * A Fenwick tree over the x coordinates 0..max_x, where every Fenwick node
+ * is an order statistic tree (RBTree by default) of the (y,x) pairs of the
+ * points in its x range. insert, erase and count touch O(log max_x) trees
+ * and each tree operation is O(log n), so all three are O(log max_x log n).
+ * Every point is stored in O(log max_x) trees and a tree is only allocated
+ * once a point falls into its range, so memory is O(n log max_x + max_x) words.
+ *
+ * Tree is any of the order statistic trees of this repo taking <T,Comp>.
+ */
+template<template<class,class> class Tree = RBTree>
+class DominanceCounter {
+    typedef std::pair<int,int> point; // (y,x)
+
+    /**
+     * a probe that sorts after every (y,x) with y <= Y
+     * so that order_of_key(probe) counts the points with y <= Y
+     */
+    struct y_at_most {
+        int y;
+    };
+
+    struct point_less {
+        typedef void is_transparent;
+
+        bool operator()(const point& a,const point& b) const {return a<b;}
+        bool operator()(const point& a,const y_at_most& b) const {return a.first<=b.y;}
+        bool operator()(const y_at_most& a,const point& b) const {return a.y<b.first;}
+    };
+
+    typedef Tree<point,point_less> tree_t;
+
+    int max_x;
+    unsigned count_points = 0;
+    std::vector<tree_t*> fenwick; // 1 indexed, fenwick[i] covers x in (i-(i&-i), i] shifted by one
+
+    public:
+    /**
+     * points must have 0 <= x <= max_x
+     */
+    explicit DominanceCounter(int max_x) : max_x(max_x), fenwick(max_x+2,nullptr) {}
+
+    DominanceCounter(const DominanceCounter&) = delete;
+    DominanceCounter& operator=(const DominanceCounter&) = delete;
+
+    /**
+     * Inserts the point (x,y)
+     * If the point already exists it does nothing.
+     */
+    void insert(int x,int y) {
+        if(contains(x,y)) return;
+        point p(y,x);
+        for(int i=x+1;i<=max_x+1;i+=i&-i) {
+            if(fenwick[i]==nullptr) fenwick[i] = new tree_t();
+            fenwick[i]->insert(p);
+        }
+        count_points++;
+    }
+
+    /**
+     * Erases the point (x,y), returns false if it was not present
+     */
+    bool erase(int x,int y) {
+        if(!contains(x,y)) return false;
+        point p(y,x);
+        for(int i=x+1;i<=max_x+1;i+=i&-i) {
+            fenwick[i]->erase(fenwick[i]->find(p));
+        }
+        count_points--;
+        return true;
+    }
+
+    bool contains(int x,int y) {
+        tree_t* t = fenwick[x+1];
+        return t!=nullptr && t->find(point(y,x))!=t->end();
+    }
+
+    /**
+     * number of points with x <= X and y <= Y
+     */
+    int count(int X,int Y) {
+        if(X<0) return 0;
+        if(X>max_x) X = max_x;
+        int c = 0;
+        y_at_most probe = {Y};
+        for(int i=X+1;i>0;i-=i&-i) {
+            if(fenwick[i]!=nullptr) c += fenwick[i]->order_of_key(probe);
+        }
+        return c;
+    }
+
+    unsigned size() {
+        return count_points;
+    }
+
+    bool empty() {
+        return count_points==0;
+    }
+
+    ~DominanceCounter() {
+        for(tree_t* t : fenwick) delete t;
+    }
+};
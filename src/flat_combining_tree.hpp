@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rb_tree.hpp"
+
+/**
+ * Flat combining front end that lets many threads share one single
+ * threaded tree, for write heavy workloads where a lock around the tree
+ * collapses as soon as several threads write.
+ *
+ * A thread publishes its request (insert, erase, find, order_of_key,
+ * find_by_order) in a slot of a publication array and waits on that slot.
+ * Whichever waiting thread gets the combiner lock collects every pending
+ * request, sorts the batch by key in the tree's own order (its
+ * key_compare) so that consecutive descents share the upper levels of the
+ * tree in cache, applies it and hands each request its result. Waiting threads only read their own slot and a combining
+ * flag, and try the lock only while the flag says nobody combines, so the
+ * lock and the tree's cache lines stay with one thread at a time instead
+ * of moving between all of them on every operation.
+ *
+ * The requests of a batch are concurrent, so the sorted order is a valid
+ * linearization. A thread starts looking for a free slot at its own number
+ * (the running threads are numbered densely from 0) and the combiner only
+ * scans up to the highest slot ever claimed. Any number of threads works,
+ * with more threads than slots some wait for a free one.
+ *
+ * The tree classes keep their NILL sentinel in a static member that some
+ * of them write while updating, so no other tree of the same class may be
+ * modified on another thread while this one is in use.
+ */
+template<class T,class Tree = RBTree<T>>
+class flat_combining_tree {
+    enum op_code {op_insert,op_erase,op_find,op_order_of_key,op_find_by_order};
+    enum slot_state {slot_free,slot_claimed,slot_pending,slot_done};
+
+    static const int SPINS = 64;   // busy polls before a waiting thread yields
+    static const int PASSES = 4;   // collections per combiner turn while requests keep coming
+
+    /**
+     * one request and its result, padded so that the state of
+     * neighbouring slots is never on the same cache line
+     */
+    struct slot {
+        std::atomic<int> state{slot_free};
+        op_code op;
+        T key;
+        int rank;
+        int result;
+        bool flag; // inserted, erased or found
+        char pad[64];
+    };
+
+    typedef typename Tree::key_compare Comp;
+
+    Tree tree;
+    Comp comp; // the tree's own order, the batches are sorted by it
+    std::vector<slot> slots;
+    std::atomic<std::size_t> used{0}; // slots past the highest one ever claimed are never scanned
+    std::mutex combiner;
+    std::atomic<bool> combining{false}; // set while a thread holds combiner to combine
+    std::vector<slot*> batch; // only touched by the combiner
+    std::atomic<unsigned long long> num_batches{0};
+    std::atomic<unsigned long long> num_combined{0};
+
+    /**
+     * small number of the calling thread, unique among the running
+     * threads, the numbers of finished threads are reused
+     */
+    static unsigned thread_index() {
+        struct registry {
+            std::mutex m;
+            std::vector<bool> taken;
+        };
+        static registry r;
+
+        struct number {
+            unsigned index = 0;
+
+            number() {
+                std::lock_guard<std::mutex> lock(r.m);
+                while(index<r.taken.size() && r.taken[index]) index++;
+                if(index==r.taken.size()) r.taken.push_back(true);
+                else r.taken[index] = true;
+            }
+
+            ~number() {
+                std::lock_guard<std::mutex> lock(r.m);
+                r.taken[index] = false;
+            }
+        };
+        static thread_local number n;
+        return n.index;
+    }
+
+    slot& claim() {
+        std::size_t n = slots.size();
+        for(std::size_t i=thread_index(),tries=1;;i++,tries++) {
+            slot& s = slots[i%n];
+            int expected = slot_free;
+            if(s.state.load(std::memory_order_relaxed)==slot_free
+               && s.state.compare_exchange_strong(expected,slot_claimed,std::memory_order_acquire)) {
+                std::size_t end = i%n+1;
+                for(std::size_t u=used.load();u<end && !used.compare_exchange_weak(u,end););
+                return s;
+            }
+            if(tries%n==0) std::this_thread::yield();
+        }
+    }
+
+    /**
+     * keyed requests in key order, then find_by_order in rank order
+     */
+    bool before(const slot* a,const slot* b) {
+        bool ka = a->op!=op_find_by_order, kb = b->op!=op_find_by_order;
+        if(ka!=kb) return ka;
+        if(!ka) return a->rank<b->rank;
+        return comp(a->key,b->key);
+    }
+
+    void apply(slot& s) {
+        switch(s.op) {
+            case op_insert: {
+                unsigned before = tree.size();
+                s.result = tree.insert(s.key).second;
+                s.flag = tree.size()!=before;
+                break;
+            }
+            case op_erase:
+                s.flag = tree.erase(s.key);
+                break;
+            case op_find:
+                s.flag = tree.find(s.key)!=tree.end();
+                break;
+            case op_order_of_key:
+                s.result = tree.order_of_key(s.key);
+                break;
+            case op_find_by_order: {
+                auto it = tree.find_by_order(s.rank);
+                s.flag = it!=tree.end();
+                if(s.flag) s.key = *it;
+                break;
+            }
+        }
+    }
+
+    /**
+     * called with the combiner lock held
+     */
+    void combine() {
+        for(int pass=0;pass<PASSES;pass++) {
+            batch.clear();
+            std::size_t end = used.load(std::memory_order_acquire);
+            for(std::size_t i=0;i<end;i++) {
+                if(slots[i].state.load(std::memory_order_acquire)==slot_pending) batch.push_back(&slots[i]);
+            }
+            if(batch.empty()) return;
+
+            std::sort(batch.begin(),batch.end(),[this](const slot* a,const slot* b) {return before(a,b);});
+            for(slot* s : batch) apply(*s);
+            for(slot* s : batch) s->state.store(slot_done,std::memory_order_release);
+
+            num_batches.fetch_add(1,std::memory_order_relaxed);
+            num_combined.fetch_add(batch.size(),std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * publishes the request and waits until some combiner, possibly this
+     * thread, has applied it; the caller reads the result and calls release
+     */
+    slot& request(op_code op,const T& key,int rank) {
+        slot& s = claim();
+        s.op = op;
+        s.key = key;
+        s.rank = rank;
+        s.state.store(slot_pending,std::memory_order_release);
+
+        // only the own slot and the combining flag are polled, the lock is
+        // only tried while nobody combines
+        for(int spins=1;s.state.load(std::memory_order_relaxed)!=slot_done;spins++) {
+            if(!combining.load(std::memory_order_relaxed) && combiner.try_lock()) {
+                combining.store(true,std::memory_order_relaxed);
+                combine();
+                combining.store(false,std::memory_order_relaxed);
+                combiner.unlock();
+            } else if(spins%SPINS==0) {
+                std::this_thread::yield();
+            }
+        }
+        s.state.load(std::memory_order_acquire); // pairs with the combiner's release of slot_done
+        return s;
+    }
+
+    static void release(slot& s) {
+        s.state.store(slot_free,std::memory_order_release);
+    }
+
+    public:
+    /**
+     * num_slots requests can be published at once, at least the number
+     * of threads that use the tree is best
+     */
+    explicit flat_combining_tree(unsigned num_slots = 128) : slots(num_slots==0 ? 1 : num_slots) {}
+
+    flat_combining_tree(const flat_combining_tree&) = delete;
+    flat_combining_tree& operator=(const flat_combining_tree&) = delete;
+
+    /**
+     * returns whether key was inserted and its rank
+     */
+    std::pair<bool,int> insert(const T& key) {
+        slot& s = request(op_insert,key,0);
+        std::pair<bool,int> r(s.flag,s.result);
+        release(s);
+        return r;
+    }
+
+    bool erase(const T& key) {
+        slot& s = request(op_erase,key,0);
+        bool r = s.flag;
+        release(s);
+        return r;
+    }
+
+    bool contains(const T& key) {
+        slot& s = request(op_find,key,0);
+        bool r = s.flag;
+        release(s);
+        return r;
+    }
+
+    int order_of_key(const T& key) {
+        slot& s = request(op_order_of_key,key,0);
+        int r = s.result;
+        release(s);
+        return r;
+    }
+
+    /**
+     * copies the kth smallest key (0 indexed) into out
+     * returns false if k is out of range
+     */
+    bool find_by_order(int k,T& out) {
+        slot& s = request(op_find_by_order,T(),k);
+        bool r = s.flag;
+        if(r) out = s.key;
+        release(s);
+        return r;
+    }
+
+    unsigned size() {
+        std::lock_guard<std::mutex> lock(combiner);
+        return tree.size();
+    }
+
+    /**
+     * combiner turns that found requests, and the requests they applied,
+     * the ratio is the average batch size
+     */
+    unsigned long long batches() {
+        return num_batches.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long combined_requests() {
+        return num_combined.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * the tree itself, only while no thread uses the wrapper
+     */
+    Tree& underlying() {
+        return tree;
+    }
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * FrozenSet Class
+ * An immutable order statistic set of at most N keys that can be built
+ * at compile time, e.g.
+ *
+ *     constexpr auto codes = make_frozen_set({404,200,500,301});
+ *     static_assert(codes.order_of_key(404)==2,"");
+ *
+ * Duplicate keys are kept once. Everything is constexpr, a constexpr
+ * FrozenSet is emitted as initialized data and costs nothing at startup.
+ *
+ * The keys are stored twice: sorted, for find_by_order and iteration,
+ * and in Eytzinger (BFS) order together with their ranks, for searches.
+ * The Eytzinger descent reads consecutive slots in the first levels and
+ * has no data dependent branch, so it stays fast on tables past the cache.
+ *
+ * T must be a literal type with a constexpr default constructor,
+ * Comp must have a constexpr operator() (std::less does since C++14).
+ */
+template<class T,std::size_t N,typename Comp = std::less<T>>
+class FrozenSet {
+    static_assert(N>0,"a FrozenSet needs room for at least one key");
+
+    Comp comp;
+    std::size_t n = 0;
+    T keys[N] = {};
+    T eytz[N+1] = {}; // 1 indexed, eytz[i] has children 2i and 2i+1
+    std::size_t eytz_rank[N+1] = {}; // rank of eytz[i], eytz_rank[0] = n
+
+    constexpr void swap(T& a,T& b) {
+        T t = a;
+        a = b;
+        b = t;
+    }
+
+    /**
+     * restores the max heap property below i in keys[0..len)
+     */
+    constexpr void sift_down(std::size_t i,std::size_t len) {
+        while(2*i+1<len) {
+            std::size_t c = 2*i+1;
+            if(c+1<len && comp(keys[c],keys[c+1])) c++;
+            if(!comp(keys[i],keys[c])) return;
+            swap(keys[i],keys[c]);
+            i = c;
+        }
+    }
+
+    /**
+     * heapsort, O(N log N) steps so that large tables still
+     * fit in the compiler's constexpr evaluation limits
+     */
+    constexpr void sort() {
+        for(std::size_t i=N/2;i-->0;) sift_down(i,N);
+        for(std::size_t len=N;len-->1;) {
+            swap(keys[0],keys[len]);
+            sift_down(0,len);
+        }
+    }
+
+    /**
+     * fills the Eytzinger subtree rooted at i with the keys from rank k on
+     * in order, returns the next rank
+     */
+    constexpr std::size_t build_eytzinger(std::size_t i,std::size_t k) {
+        if(i>n) return k;
+        k = build_eytzinger(2*i,k);
+        eytz[i] = keys[k];
+        eytz_rank[i] = k;
+        return build_eytzinger(2*i+1,k+1);
+    }
+
+    /**
+     * returns number of keys smaller than val
+     * K is T or, with a transparent comparator, any type Comp can compare with T
+     */
+    template<class K>
+    constexpr std::size_t order_of_key_rank(const K& val) const {
+        std::size_t i = 1;
+        while(i<=n) i = 2*i + (comp(eytz[i],val)?1:0);
+        // the last left turn of the descent is the lower bound,
+        // drop the trailing right turns and that left turn
+        while(i&1) i >>= 1;
+        i >>= 1;
+        return eytz_rank[i];
+    }
+
+    template<class K>
+    constexpr const T* find_key(const K& val) const {
+        std::size_t k = order_of_key_rank(val);
+        if(k<n && !comp(val,keys[k])) return keys+k;
+        return keys+n;
+    }
+
+    public:
+    typedef const T* iterator;
+
+    /**
+     * builds the set from an array of N keys in any order
+     */
+    constexpr FrozenSet(const T (&init)[N],const Comp& comp = Comp()) : comp(comp) {
+        for(std::size_t i=0;i<N;i++) keys[i] = init[i];
+        sort();
+        for(std::size_t i=0;i<N;i++) {
+            if(n==0 || comp(keys[n-1],keys[i])) keys[n++] = keys[i];
+        }
+        eytz_rank[0] = n;
+        build_eytzinger(1,0);
+    }
+
+    /**
+     * returns number of keys smaller than val
+     */
+    constexpr std::size_t order_of_key(const T& val) const {
+        return order_of_key_rank(val);
+    }
+
+    /**
+     * heterogeneous lookup, only with a transparent Comp
+     */
+    template<class K,class C = Comp,class = typename C::is_transparent>
+    constexpr std::size_t order_of_key(const K& val) const {
+        return order_of_key_rank(val);
+    }
+
+    /**
+     * returns end() if val is not in the set
+     */
+    constexpr iterator find(const T& val) const {
+        return find_key(val);
+    }
+
+    template<class K,class C = Comp,class = typename C::is_transparent>
+    constexpr iterator find(const K& val) const {
+        return find_key(val);
+    }
+
+    constexpr bool contains(const T& val) const {
+        return find_key(val)!=end();
+    }
+
+    /**
+     * Finds the kth smallest key
+     * k is 0 indexed, returns end() when out of range
+     */
+    constexpr iterator find_by_order(std::size_t k) const {
+        if(k>=n) return end();
+        return keys+k;
+    }
+
+    constexpr iterator begin() const {
+        return keys;
+    }
+
+    constexpr iterator end() const {
+        return keys+n;
+    }
+
+    constexpr std::size_t size() const {
+        return n;
+    }
+
+    constexpr bool empty() const {
+        return n==0;
+    }
+};
+
+/**
+ * deduces T and N from a braced list, make_frozen_set({3,1,2})
+ */
+template<class T,typename Comp = std::less<T>,std::size_t N>
+constexpr FrozenSet<T,N,Comp> make_frozen_set(const T (&keys)[N],const Comp& comp = Comp()) {
+    return FrozenSet<T,N,Comp>(keys,comp);
+}
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <utility>
+
+#include "balancing.hpp"
+#include "rb_tree.hpp"
+
+/**
+ * Interval Tree Class
+ * A red-black tree of closed intervals [lo,hi] ordered by (lo,hi),
+ * augmented with the maximum hi in every subtree.
+ * Can't insert the same interval more than once
+ *
+ * find_overlapping and for_each_overlapping descend on the max_hi
+ * augmentation. count_overlapping is O(log n) through the order statistics:
+ * an interval overlaps [lo,hi] iff it starts at or before hi and does not
+ * end before lo, so the count is #(start <= hi) - #(end < lo). The first term
+ * comes from the sizes in this tree, the second from an RBTree of endpoints.
+ *
+ * The endpoint tree (ends) is what that count costs: it holds every
+ * interval a second time, as a (hi,lo) node with its own augmentation, so
+ * it about doubles the memory of the tree, and every insert and erase does
+ * a second descent and red-black fixup in it. The other queries don't
+ * read it.
+ *
+ * The balancing is RBTree's (balancing.hpp), max_hi is kept by the
+ * relax_augmentation hook it calls after every rotation and on the way up.
+ */
+template<class T,typename Comp = std::less<T>>
+class IntervalTree {
+    struct node {
+        T lo;
+        T hi;
+        T max_hi;
+        int size = 0;
+        node* child[2]; // left, right
+        node* parent;
+        rb_color color = black;
+
+        node(const T& lo,const T& hi,node* left,node* right,node* parent) : lo(lo), hi(hi), max_hi(hi),
+        size(1), child{left,right}, parent(parent), color(red) {}
+
+        node() : child{nullptr,nullptr},parent(nullptr), color(black) {}
+    };
+
+    /**
+     * orders (hi,lo) pairs of the endpoint index by hi then lo
+     * transparent so that order_of_key(v) counts the intervals ending before v
+     */
+    struct end_less {
+        typedef void is_transparent;
+        Comp comp;
+
+        bool operator()(const std::pair<T,T>& a,const std::pair<T,T>& b) const {
+            if(comp(a.first,b.first)) return true;
+            if(comp(b.first,a.first)) return false;
+            return comp(a.second,b.second);
+        }
+        bool operator()(const std::pair<T,T>& a,const T& b) const {return comp(a.first,b);}
+        bool operator()(const T& a,const std::pair<T,T>& b) const {return comp(a,b.first);}
+    };
+
+    Comp comp;
+    RBTree<std::pair<T,T>,end_less> ends;
+
+    static node NULL_NODE;
+    static node* NILL;
+
+    static node* successor(node* x) {
+        if(x->child[1]!=NILL) {
+            x=x->child[1];
+            while(x->child[0]!=NILL) x=x->child[0];
+            return x;
+        }
+
+        node* y = x->parent;
+        while(y!=NILL && y->child[1]==x) {
+            x = y;
+            y = x->parent;
+        }
+
+        return y;
+    }
+
+    static node* predecessor(node* x) {
+        if(x->child[0]!=NILL) {
+            x=x->child[0];
+            while(x->child[1]!=NILL) {
+                x=x->child[1];
+            }
+            return x;
+        }
+
+        node* y = x->parent;
+        while(y!=NILL && y->child[0]==x) {
+            x = y;
+            y = x->parent;
+        }
+
+        return y;
+    }
+
+
+    /**
+     * private helper function
+     * to help destructor to deallocate all memory
+     * recursively in linear time
+     */
+    void erase_sub_tree(node* x) {
+        if(x==NILL) return;
+        erase_sub_tree(x->child[0]);
+        erase_sub_tree(x->child[1]);
+        delete x;
+    }
+
+    class iterator {
+        friend class IntervalTree<T,Comp>;
+        node* it;
+        iterator(node* iter) : it(iter) {}
+    public:
+        iterator() {};
+
+        iterator& operator++() {
+            it = successor(it);
+            return *this;
+        }
+
+        iterator& operator--() {
+            it = predecessor(it);
+            return *this;
+        }
+
+        std::pair<T,T> operator*() const {return std::make_pair(it->lo,it->hi);}
+        bool operator==(const iterator& rhs) const {return it==rhs.it;}
+        bool operator!=(const iterator& rhs) const {return it!=rhs.it;}
+        iterator& operator=(const iterator& rhs) {
+            it = rhs.it;
+            return *this;
+        }
+    };
+
+    node* root = NILL;
+
+
+    /**
+     * (lo1,hi1) < (lo2,hi2) in the order of the tree
+     */
+    inline bool less(const T& lo1,const T& hi1,const T& lo2,const T& hi2) {
+        if(comp(lo1,lo2)) return true;
+        if(comp(lo2,lo1)) return false;
+        return comp(hi1,hi2);
+    }
+
+    /**
+     * if x is NILL it keeps the status quo
+     * Otherwise it updates the size and max_hi assuming that it's children
+     * have valid augmentation
+     */
+    inline void relax_augmentation(node* x) {
+        if(x==NILL) return;
+        x->size = x->child[0]->size + x->child[1]->size + 1;
+        x->max_hi = x->hi;
+        if(x->child[0]!=NILL && comp(x->max_hi,x->child[0]->max_hi)) x->max_hi = x->child[0]->max_hi;
+        if(x->child[1]!=NILL && comp(x->max_hi,x->child[1]->max_hi)) x->max_hi = x->child[1]->max_hi;
+    }
+
+    /**
+     * the shared red-black engine (balancing.hpp) on this tree, with
+     * relax_augmentation, which also keeps max_hi, as its augmentation hook
+     */
+    auto engine() {
+        return make_balancer(root,NILL,[this](node* x) {relax_augmentation(x);});
+    }
+
+    /**
+     * A helper function for the erase(iterator) method
+     * z can't be NILL
+     */
+    void erase(node* z) {
+        engine().rb_unlink(z);
+        delete z;
+    }
+
+    /**
+     * reports every interval in the subtree rooted at x overlapping [lo,hi]
+     * subtrees whose max_hi is below lo are skipped, and so are right
+     * subtrees once the intervals start after hi
+     */
+    template<class F>
+    void for_each_overlapping(node* x,const T& lo,const T& hi,F& f) {
+        if(x==NILL || comp(x->max_hi,lo)) return;
+        for_each_overlapping(x->child[0],lo,hi,f);
+        if(comp(hi,x->lo)) return;
+        if(!comp(x->hi,lo)) f(std::make_pair(x->lo,x->hi));
+        for_each_overlapping(x->child[1],lo,hi,f);
+    }
+
+
+    public:
+    /**
+     * returns the interval [lo,hi] or end()
+     */
+    iterator find(const T& lo,const T& hi) {
+        node* x = root;
+        while(x!=NILL) {
+            if(less(x->lo,x->hi,lo,hi)) x = x->child[1];
+            else if(less(lo,hi,x->lo,x->hi)) x = x->child[0];
+            else return iterator(x);
+        }
+        return iterator(NILL);
+    }
+
+    /**
+     * Inserts the interval [lo,hi] (lo <= hi) and rebalances the tree
+     * If the interval already exists in the tree it does nothing.
+     */
+    void insert(const T& lo,const T& hi) {
+        node* y = NILL;
+        node* x = root;
+
+        while(x!=NILL) {
+            y = x;
+
+            if(less(x->lo,x->hi,lo,hi)) x = x->child[1];
+            else if(less(lo,hi,x->lo,x->hi)) x = x->child[0];
+            else return; //interval already in tree
+        }
+
+        node* z = new node(lo,hi,NILL,NILL,NILL);
+        z->parent = y;
+
+        if(y==NILL) root = z;
+        else y->child[!less(lo,hi,y->lo,y->hi)] = z;
+
+        engine().rb_insert_fixup(z);
+        ends.insert(std::make_pair(hi,lo));
+    }
+
+    void erase(iterator it) {
+        ends.erase(ends.find(std::make_pair(it.it->hi,it.it->lo)));
+        erase(it.it);
+    }
+
+    /**
+     * returns some interval containing point or end()
+     * O(log n)
+     */
+    iterator find_overlapping(const T& point) {
+        node* x = root;
+        while(x!=NILL && (comp(point,x->lo) || comp(x->hi,point))) {
+            if(x->child[0]!=NILL && !comp(x->child[0]->max_hi,point)) x = x->child[0];
+            else x = x->child[1];
+        }
+        return iterator(x);
+    }
+
+    /**
+     * calls f(interval) on every interval overlapping [lo,hi] in sorted order
+     * interval is a std::pair(lo,hi)
+     * O(min(n,(k+1) log n)) for k reported intervals
+     */
+    template<class F>
+    void for_each_overlapping(const T& lo,const T& hi,F f) {
+        for_each_overlapping(root,lo,hi,f);
+    }
+
+    /**
+     * number of intervals overlapping [lo,hi]
+     * O(log n)
+     */
+    int count_overlapping(const T& lo,const T& hi) {
+        node* x = root;
+        int starts = 0;
+        while(x!=NILL) {
+            if(!comp(hi,x->lo)) {
+                starts += x->child[0]->size+1;
+                x = x->child[1];
+            } else {
+                x = x->child[0];
+            }
+        }
+
+        return starts - ends.order_of_key(lo);
+    }
+
+    /**
+     * number of intervals containing point
+     */
+    int count_overlapping(const T& point) {
+        return count_overlapping(point,point);
+    }
+
+    bool empty() {
+        return !(root->size);
+    }
+
+    unsigned size() {
+        return root->size;
+    }
+
+    iterator begin() {
+        node* x = root;
+        if(x!=NILL) {
+            while(x->child[0]!=NILL) {
+                x=x->child[0];
+            }
+        }
+        return iterator(x);
+    }
+
+    iterator end() {
+        return iterator(NILL);
+    }
+
+    /**
+     * Finds the kth smallest interval
+     * k is 0 indexed
+     */
+    iterator find_by_order(int k) {
+        k++;
+        node* x = root;
+        while(x!=NILL) {
+            if(x->child[0]->size>=k) x = x->child[0];
+            else if(x->child[0]->size+1==k) return iterator(x);
+            else {
+                k-=(x->child[0]->size+1);
+                x = x->child[1];
+            }
+        }
+
+        return iterator(x);
+    }
+
+    ~IntervalTree() {
+        erase_sub_tree(root);
+    }
+};
+
+template<class T,class Comp>
+typename IntervalTree<T,Comp>::node IntervalTree<T,Comp>::NULL_NODE = {};
+
+
+template<class T,class Comp>
+typename IntervalTree<T,Comp>::node* IntervalTree<T,Comp>::NILL = &IntervalTree<T,Comp>::NULL_NODE;
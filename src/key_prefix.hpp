@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+
+/**
+ * Order preserving key prefixes stored inline in tree nodes.
+ *
+ * Tree nodes derive from key_prefix<T,Comp>::field. For most keys it is an
+ * empty struct (no space thanks to the empty base optimization) and
+ * compare always answers 0, so descents compile to plain Comp calls.
+ *
+ * For std::string ordered by std::less the field holds the first
+ * PREFIX_BYTES bytes of the key, big endian and zero padded, so comparing
+ * two prefixes as integers orders them like the strings. A descent
+ * compares the prefix in the node first and only dereferences the
+ * string's heap buffer when the prefixes tie.
+ */
+template<class T,class Comp>
+struct key_prefix {
+    struct field {};
+
+    static field make(const T&) {
+        return field();
+    }
+
+    static void store(field&,const T&) {}
+
+    /**
+     * <0 or >0 when the prefixes alone order the keys, 0 when Comp must decide
+     */
+    static int compare(const field&,const field&) {
+        return 0;
+    }
+};
+
+struct string_key_prefix {
+    static const int PREFIX_BYTES = 16;
+
+    struct field {
+        std::uint64_t hi = 0; // bytes 0..7
+        std::uint64_t lo = 0; // bytes 8..15
+    };
+
+    static std::uint64_t big_endian(const unsigned char* b) {
+        std::uint64_t w = 0;
+        for(int i=0;i<8;i++) w = w<<8 | b[i];
+        return w;
+    }
+
+    static field make(const std::string& key) {
+        unsigned char b[PREFIX_BYTES] = {};
+        std::memcpy(b,key.data(),key.size()<PREFIX_BYTES ? key.size() : PREFIX_BYTES);
+        field f;
+        f.hi = big_endian(b);
+        f.lo = big_endian(b+8);
+        return f;
+    }
+
+    static void store(field& f,const std::string& key) {
+        f = make(key);
+    }
+
+    /**
+     * strings compare as unsigned chars, like the prefixes, and a shorter
+     * string padded with zeros ties with a longer one it is a prefix of
+     */
+    static int compare(const field& a,const field& b) {
+        if(a.hi!=b.hi) return a.hi<b.hi ? -1 : 1;
+        if(a.lo!=b.lo) return a.lo<b.lo ? -1 : 1;
+        return 0;
+    }
+};
+
+template<>
+struct key_prefix<std::string,std::less<std::string>> : string_key_prefix {};
+
+template<>
+struct key_prefix<std::string,std::less<>> : string_key_prefix {};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * Direct mapped cache of lookup results shared by the tree headers.
+ * Every slot remembers one key together with what find found for it
+ * (the node, or NILL for an absent key) and/or its order_of_key rank.
+ *
+ * Entries are stamped with a version and the tree bumps the version on
+ * every mutation, so a mutation invalidates the whole cache in O(1).
+ * A lookup costs one hash and one slot probe before the usual descent,
+ * so the worst case stays O(log n).
+ *
+ * The hash is a std::function so that trees of keys without std::hash
+ * only need one when they enable the cache.
+ */
+template<class T,class node>
+class lookup_cache {
+    struct entry {
+        T key;
+        node* x = nullptr; // nullptr: unknown
+        int rank = -1;     // -1: unknown
+        unsigned long long version = 0;
+    };
+
+    std::vector<entry> slots;
+    std::size_t mask = 0;
+    std::function<std::size_t(const T&)> hash;
+    unsigned long long version = 1;
+
+    public:
+    unsigned long long hits = 0;
+    unsigned long long misses = 0;
+
+    bool enabled() const {
+        return !slots.empty();
+    }
+
+    /**
+     * num_slots is rounded up to a power of two, 0 disables the cache
+     */
+    void enable(std::size_t num_slots,std::function<std::size_t(const T&)> h) {
+        std::size_t n = 1;
+        while(n<num_slots) n <<= 1;
+        slots.assign(num_slots==0 ? 0 : n,entry());
+        mask = n-1;
+        hash = h;
+        hits = misses = 0;
+    }
+
+    void invalidate() {
+        version++;
+    }
+
+    void reset_stats() {
+        hits = misses = 0;
+    }
+
+    std::size_t memory_usage() const {
+        return slots.capacity()*sizeof(entry);
+    }
+
+    /**
+     * find_node(key) through the cache, eq(a,b) tells whether a and b are
+     * equivalent keys, find_node is only called on a miss
+     */
+    template<class Eq,class Find>
+    node* find(const T& key,Eq eq,Find find_node) {
+        entry& e = slot(key,eq);
+        if(e.x!=nullptr) {
+            hits++;
+        } else {
+            misses++;
+            e.x = find_node(key);
+        }
+        return e.x;
+    }
+
+    /**
+     * order_of_key(key) through the cache, like find
+     */
+    template<class Eq,class Rank>
+    int rank(const T& key,Eq eq,Rank order_of_key) {
+        entry& e = slot(key,eq);
+        if(e.rank>=0) {
+            hits++;
+        } else {
+            misses++;
+            e.rank = order_of_key(key);
+        }
+        return e.rank;
+    }
+
+    private:
+    /**
+     * the slot of key, taken over (and emptied) unless it already holds key
+     */
+    template<class Eq>
+    entry& slot(const T& key,Eq eq) {
+        entry& e = slots[hash(key)&mask];
+        if(e.version!=version || !eq(e.key,key)) {
+            e.key = key;
+            e.x = nullptr;
+            e.rank = -1;
+            e.version = version;
+        }
+        return e;
+    }
+};
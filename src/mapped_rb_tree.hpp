@@ -0,0 +1,684 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * MappedRBTree Class
+ * An RBTree whose nodes live in a memory mapped file: inserts and erases
+ * go straight to the file and reopening it after a restart gives back the
+ * live tree instantly, nothing is rebuilt or even read up front.
+ * Can't insert the same key more than once
+ *
+ * File layout: a header, then an array of node slots. Links are slot
+ * indices instead of pointers, slot 0 is the NILL sentinel, so the mapping
+ * may move when the file grows and may land anywhere after a restart.
+ * Erased slots are kept in a free list threaded through their right links
+ * (child[1]).
+ *
+ * Durability: the kernel writes dirty pages back on its own schedule,
+ * sync() forces it. checkpoint() syncs and marks the file clean, every
+ * update marks it dirty before touching a node, so was_clean() after open()
+ * tells whether the previous session ended with a checkpoint (close() does
+ * one). An update torn by a crash is not repaired.
+ *
+ * T must be trivially copyable, and the file is only portable between
+ * builds with the same T and node layout (checked on open). Linux only.
+ */
+template<class T,typename Comp = std::less<T>>
+class MappedRBTree {
+    static_assert(std::is_trivially_copyable<T>::value,"keys are stored in the file as raw bytes");
+
+    typedef std::uint32_t link;
+    enum _color : std::uint8_t {red,black};
+
+    struct node {
+        T key;
+        int size;
+        link child[2]; // left, right
+        link parent;
+        _color color;
+    };
+
+    struct header {
+        char magic[8];
+        std::uint32_t key_size;
+        std::uint32_t node_size;
+        link root;
+        link free_list;
+        std::uint32_t used;     // slots handed out so far, NILL included
+        std::uint32_t capacity; // slots backed by the file
+        std::uint32_t clean;
+        std::uint64_t checkpoints;
+    };
+
+    static const link NILL = 0;
+    static const std::uint32_t INITIAL_CAPACITY = 1024;
+
+    static const char* magic() {
+        return "MRBTREE";
+    }
+
+    static std::size_t nodes_offset() {
+        return (sizeof(header)+alignof(node)-1)/alignof(node)*alignof(node);
+    }
+
+    static std::size_t file_bytes(std::uint32_t slots) {
+        return nodes_offset()+std::size_t(slots)*sizeof(node);
+    }
+
+    Comp comp;
+
+    int fd = -1;
+    char* base = nullptr;
+    std::size_t mapped_bytes = 0;
+    bool opened_clean = false;
+    unsigned checkpoint_every = 0;
+    unsigned updates_since_checkpoint = 0;
+
+    header* head() const {
+        return reinterpret_cast<header*>(base);
+    }
+
+    node& nd(link x) const {
+        return reinterpret_cast<node*>(base+nodes_offset())[x];
+    }
+
+    link& root() const {
+        return head()->root;
+    }
+
+    class iterator {
+        friend class MappedRBTree<T,Comp>;
+        const MappedRBTree<T,Comp>* tree;
+        link it;
+        iterator(const MappedRBTree<T,Comp>* tree,link iter) : tree(tree), it(iter) {}
+    public:
+        iterator() {};
+
+        iterator& operator++() {
+            it = tree->successor(it);
+            return *this;
+        }
+
+        iterator& operator--() {
+            it = tree->predecessor(it);
+            return *this;
+        }
+
+        T operator*() const {return tree->nd(it).key;}
+        bool operator==(const iterator& rhs) const {return it==rhs.it;}
+        bool operator!=(const iterator& rhs) const {return it!=rhs.it;}
+        iterator& operator=(const iterator& rhs) {
+            tree = rhs.tree;
+            it = rhs.it;
+            return *this;
+        }
+    };
+
+    link successor(link x) const {
+        if(nd(x).child[1]!=NILL) {
+            x=nd(x).child[1];
+            while(nd(x).child[0]!=NILL) x=nd(x).child[0];
+            return x;
+        }
+
+        link y = nd(x).parent;
+        while(y!=NILL && nd(y).child[1]==x) {
+            x = y;
+            y = nd(x).parent;
+        }
+
+        return y;
+    }
+
+    link predecessor(link x) const {
+        if(nd(x).child[0]!=NILL) {
+            x=nd(x).child[0];
+            while(nd(x).child[1]!=NILL) x=nd(x).child[1];
+            return x;
+        }
+
+        link y = nd(x).parent;
+        while(y!=NILL && nd(y).child[0]==x) {
+            x = y;
+            y = nd(x).parent;
+        }
+
+        return y;
+    }
+
+    /**
+     * unmaps and closes whatever is open, always returns false
+     * so that open can bail out with return fail()
+     */
+    bool fail() {
+        if(base!=nullptr) munmap(base,mapped_bytes);
+        if(fd>=0) ::close(fd);
+        base = nullptr;
+        fd = -1;
+        mapped_bytes = 0;
+        return false;
+    }
+
+    /**
+     * doubles the number of slots backed by the file
+     * invalidates every node reference, links stay valid
+     */
+    bool grow() {
+        std::uint32_t capacity = head()->capacity*2;
+        std::size_t bytes = file_bytes(capacity);
+        if(ftruncate(fd,bytes)!=0) return false;
+        void* p = mremap(base,mapped_bytes,bytes,MREMAP_MAYMOVE);
+        if(p==MAP_FAILED) return false;
+        base = static_cast<char*>(p);
+        mapped_bytes = bytes;
+        head()->capacity = capacity;
+        return true;
+    }
+
+    /**
+     * takes a slot from the free list or the end of the array
+     * returns NILL if the file could not grow
+     */
+    link new_node(const T& key) {
+        link z;
+        if(head()->free_list!=NILL) {
+            z = head()->free_list;
+            head()->free_list = nd(z).child[1];
+        } else {
+            if(head()->used==head()->capacity && !grow()) return NILL;
+            z = head()->used++;
+        }
+
+        node& n = nd(z);
+        n.key = key;
+        n.size = 1;
+        n.child[0] = n.child[1] = n.parent = NILL;
+        n.color = red;
+        return z;
+    }
+
+    void free_node(link z) {
+        nd(z).child[1] = head()->free_list;
+        head()->free_list = z;
+    }
+
+    /**
+     * called before an update touches the file
+     */
+    void begin_update() {
+        head()->clean = 0;
+    }
+
+    /**
+     * called after an update, checkpoints every checkpoint_every updates
+     */
+    void end_update() {
+        if(checkpoint_every!=0 && ++updates_since_checkpoint>=checkpoint_every) checkpoint();
+    }
+
+    inline void relax_augmentation(link x) {
+        if(x==NILL) return;
+        nd(x).size = nd(nd(x).child[0]).size + nd(nd(x).child[1]).size + 1;
+    }
+
+    /**
+     * x is not NILL
+     * rotates x down to side d (0 left, 1 right), its child on the other
+     * side, which must not be NILL, takes its place
+     * must adjust root when necessary
+     * must fix augmentation code locally
+     */
+    void single_rotate(link x,int d) {
+        link y = nd(x).child[!d];
+
+        nd(x).child[!d] = nd(y).child[d];
+        if(nd(x).child[!d]!=NILL) nd(nd(x).child[!d]).parent = x;
+
+        nd(y).parent = nd(x).parent;
+        if(nd(y).parent==NILL) {
+            root() = y;
+        } else {
+            nd(nd(y).parent).child[x==nd(nd(x).parent).child[1]] = y;
+        }
+
+        nd(y).child[d] = x;
+        nd(x).parent = y;
+
+        relax_augmentation(x);
+        relax_augmentation(y);
+    }
+
+    /**
+     * relaxes augmentation on the path from y to the root
+     */
+    void fix_augmentation(link y) {
+        while(y!=root()) {
+            relax_augmentation(y);
+            y = nd(y).parent;
+        }
+
+        relax_augmentation(root());
+    }
+
+    /**
+     * same as the shared rb_insert_fixup (balancing.hpp) on slot links
+     */
+    void rb_insert_fixup(link z) {
+        while(nd(nd(z).parent).color==red) {
+            link p = nd(z).parent;
+            link g = nd(p).parent;
+            // d is the side of p, the uncle is on the other side
+            int d = p==nd(g).child[1];
+            link uncle = nd(g).child[!d];
+            if(nd(uncle).color==red) {
+                nd(g).color = red;
+                nd(uncle).color = black;
+                nd(p).color = black;
+
+                relax_augmentation(p);
+                relax_augmentation(g);
+
+                z = g;
+            } else {
+                if(z==nd(p).child[!d]) {
+                    z = p;
+                    single_rotate(z,d);
+                }
+                p = nd(z).parent;
+                g = nd(p).parent;
+                nd(p).color = black;
+                nd(g).color = red;
+                relax_augmentation(g);
+                single_rotate(g,!d);
+            }
+        }
+
+        fix_augmentation(z);
+        nd(root()).color = black;
+    }
+
+    /**
+     * replaces subtree rooted at u with subtree rooted at v
+     * DOES NOT FIX AUGMENTATION OR PRESERVE RB PROPERTIES
+     */
+    inline void transplant(link u,link v) {
+        link p = nd(u).parent;
+        if(p==NILL) {
+            root() = v;
+        } else {
+            nd(p).child[nd(p).child[1]==u] = v;
+        }
+        nd(v).parent = p;
+    }
+
+    /**
+     * A helper function for the erase(iterator) method
+     * z can't be NILL
+     */
+    void erase_node(link z) {
+        link y = z;
+        _color y_original_color = nd(y).color;
+        link x;
+        if(nd(z).child[0]==NILL || nd(z).child[1]==NILL) {
+            x = nd(z).child[nd(z).child[0]==NILL];
+            transplant(z,x);
+        } else {
+            y = successor(z); //y is not NILL and y has no left child cause z's right child is not NILL
+            y_original_color = nd(y).color;
+            x = nd(y).child[1];
+            if(nd(y).parent==z) {
+                nd(x).parent = y;
+            } else {
+                transplant(y,x);
+                nd(y).child[1] = nd(z).child[1];
+                nd(nd(y).child[1]).parent = y;
+            }
+
+            transplant(z,y);
+            nd(y).child[0] = nd(z).child[0];
+            nd(nd(y).child[0]).parent = y;
+            nd(y).color = nd(z).color;
+        }
+
+        free_node(z);
+        if(y_original_color==black) {
+            rb_delete_fix_up(x);
+        } else {
+            fix_augmentation(x);
+        }
+    }
+
+    /**
+     * same as the shared rb_delete_fixup (balancing.hpp) on slot links
+     * x may be NILL, its parent was set by erase
+     */
+    void rb_delete_fix_up(link x) {
+        link fixer = x;
+        while(x!=root() && nd(x).color==black) {
+            link p = nd(x).parent;
+            // d is the side of x, its brother is on the other side
+            int d = x==nd(p).child[1];
+            link brother = nd(p).child[!d];
+            if(nd(brother).color==red) {
+                nd(brother).color = black;
+                nd(p).color = red;
+                single_rotate(p,d);
+                brother = nd(p).child[!d];
+            }
+
+            if(nd(nd(brother).child[0]).color==black && nd(nd(brother).child[1]).color==black) {
+                nd(brother).color = red;
+                relax_augmentation(x);
+                x = p;
+            } else {
+                if(nd(nd(brother).child[!d]).color==black) {
+                    nd(nd(brother).child[d]).color = black;
+                    nd(brother).color = red;
+                    single_rotate(brother,!d);
+                    brother = nd(p).child[!d];
+                }
+
+                nd(brother).color = nd(p).color;
+                nd(p).color = black;
+                nd(nd(brother).child[!d]).color = black;
+                single_rotate(p,d);
+                fixer = x;
+                x = root();
+            }
+        }
+
+        fix_augmentation(fixer);
+        nd(x).color = black;
+    }
+
+    public:
+    MappedRBTree() {}
+
+    /**
+     * same as calling open(path), check is_open()
+     */
+    explicit MappedRBTree(const char* path) {
+        open(path);
+    }
+
+    MappedRBTree(const MappedRBTree&) = delete;
+    MappedRBTree& operator=(const MappedRBTree&) = delete;
+
+    /**
+     * Opens the tree stored in path, creating an empty one if the file
+     * does not exist or is empty
+     * returns false if the file can't be mapped or holds something else
+     * (another key type or node layout)
+     */
+    bool open(const char* path) {
+        close();
+        fd = ::open(path,O_RDWR|O_CREAT,0644);
+        if(fd<0) return false;
+
+        struct stat st;
+        if(fstat(fd,&st)!=0) return fail();
+        bool fresh = st.st_size==0;
+        if(fresh) {
+            if(ftruncate(fd,file_bytes(INITIAL_CAPACITY))!=0) return fail();
+            mapped_bytes = file_bytes(INITIAL_CAPACITY);
+        } else {
+            if(std::size_t(st.st_size)<nodes_offset()+sizeof(node)) return fail();
+            mapped_bytes = st.st_size;
+        }
+
+        void* p = mmap(nullptr,mapped_bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+        if(p==MAP_FAILED) return fail();
+        base = static_cast<char*>(p);
+
+        header* h = head();
+        if(fresh) {
+            std::memcpy(h->magic,magic(),sizeof(h->magic));
+            h->key_size = sizeof(T);
+            h->node_size = sizeof(node);
+            h->root = NILL;
+            h->free_list = NILL;
+            h->used = 1;
+            h->capacity = INITIAL_CAPACITY;
+            h->clean = 1;
+            h->checkpoints = 0;
+
+            node& nill = nd(NILL);
+            nill.size = 0;
+            nill.child[0] = nill.child[1] = nill.parent = NILL;
+            nill.color = black;
+        } else if(std::memcmp(h->magic,magic(),sizeof(h->magic))!=0 || h->key_size!=sizeof(T)
+                  || h->node_size!=sizeof(node) || file_bytes(h->capacity)>mapped_bytes) {
+            return fail();
+        }
+
+        opened_clean = h->clean;
+        updates_since_checkpoint = 0;
+        return true;
+    }
+
+    bool is_open() {
+        return base!=nullptr;
+    }
+
+    /**
+     * whether the file was checkpointed after its last update when it was opened
+     */
+    bool was_clean() {
+        return opened_clean;
+    }
+
+    /**
+     * number of checkpoints over the whole life of the file
+     */
+    std::uint64_t checkpoints() {
+        return head()->checkpoints;
+    }
+
+    /**
+     * flushes dirty pages to the file
+     * wait = false only schedules the write back (MS_ASYNC)
+     */
+    bool sync(bool wait = true) {
+        return msync(base,mapped_bytes,wait?MS_SYNC:MS_ASYNC)==0;
+    }
+
+    /**
+     * marks the file clean and flushes it synchronously
+     */
+    bool checkpoint() {
+        head()->clean = 1;
+        head()->checkpoints++;
+        updates_since_checkpoint = 0;
+        return sync(true);
+    }
+
+    /**
+     * checkpoints automatically after every n updates, 0 (default) disables it
+     */
+    void set_checkpoint_every(unsigned n) {
+        checkpoint_every = n;
+    }
+
+    /**
+     * checkpoints and unmaps the file, the tree is closed afterwards
+     */
+    void close() {
+        if(base==nullptr) return;
+        checkpoint();
+        fail();
+    }
+
+    iterator find(const T& val) {
+        link x = root();
+        while(x!=NILL) {
+            if(comp(nd(x).key,val)) x = nd(x).child[1];
+            else if(comp(val,nd(x).key)) x = nd(x).child[0];
+            else return iterator(this,x);
+        }
+        return end();
+    }
+
+    /**
+     * Inserts val if it is not present yet
+     * Returns an iterator to the element equivalent to val and its rank,
+     * counted on the way down, whether it was inserted or already present
+     * Returns (end(),-1) if the file could not grow
+     */
+    std::pair<iterator,int> insert(const T& val) {
+        link y = NILL;
+        link x = root();
+        int rank = 0;
+
+        while(x!=NILL) {
+            y = x;
+            if(comp(nd(x).key,val)) {
+                rank += nd(nd(x).child[0]).size + 1;
+                x = nd(x).child[1];
+            } else if(comp(val,nd(x).key)) {
+                x = nd(x).child[0];
+            } else {
+                return std::make_pair(iterator(this,x),rank+nd(nd(x).child[0]).size); //value already in tree
+            }
+        }
+
+        begin_update();
+        link z = new_node(val);
+        if(z==NILL) return std::make_pair(end(),-1);
+        nd(z).parent = y;
+
+        if(y==NILL) root() = z;
+        else nd(y).child[!comp(val,nd(y).key)] = z;
+
+        rb_insert_fixup(z);
+        end_update();
+        return std::make_pair(iterator(this,z),rank);
+    }
+
+    void erase(iterator it) {
+        begin_update();
+        erase_node(it.it);
+        end_update();
+    }
+
+    /**
+     * Erases the element equivalent to val, one descent
+     * returns false if there is none
+     */
+    bool erase(const T& val) {
+        iterator it = find(val);
+        if(it==end()) return false;
+        erase(it);
+        return true;
+    }
+
+    /**
+     * Erases the kth smallest element, k is 0 indexed
+     * returns false if k is out of range
+     */
+    bool erase_by_order(int k) {
+        iterator it = find_by_order(k);
+        if(it==end()) return false;
+        erase(it);
+        return true;
+    }
+
+    /**
+     * erases everything, the file keeps its size and the slots are reused
+     */
+    void clear() {
+        begin_update();
+        root() = NILL;
+        head()->free_list = NILL;
+        head()->used = 1;
+        end_update();
+    }
+
+    bool empty() {
+        return !(nd(root()).size);
+    }
+
+    unsigned size() {
+        return nd(root()).size;
+    }
+
+    iterator begin() {
+        link x = root();
+        if(x!=NILL) {
+            while(nd(x).child[0]!=NILL) x = nd(x).child[0];
+        }
+        return iterator(this,x);
+    }
+
+    iterator end() {
+        return iterator(this,NILL);
+    }
+
+    /**
+     * Finds the kth smallest node
+     * k is 0 indexed
+     */
+    iterator find_by_order(int k) {
+        if(k<0 || k>=nd(root()).size) return end();
+        link x = root();
+        while(true) {
+            if(nd(nd(x).child[0]).size>k) x = nd(x).child[0];
+            else if(nd(nd(x).child[0]).size==k) return iterator(this,x);
+            else {
+                k -= nd(nd(x).child[0]).size+1;
+                x = nd(x).child[1];
+            }
+        }
+    }
+
+    /**
+     * returns number of nodes smaller than val
+     */
+    int order_of_key(const T& val) {
+        link x = root();
+        int p = 0;
+        while(x!=NILL) {
+            if(comp(nd(x).key,val)) {
+                p += nd(nd(x).child[0]).size + 1;
+                x = nd(x).child[1];
+            } else {
+                x = nd(x).child[0];
+            }
+        }
+
+        return p;
+    }
+
+    /**
+     * out[i] = the key of rank ranks[i], ranks must be sorted
+     * one descent per rank, the batched traversal of the pointer trees
+     * is not shared with the slot links
+     */
+    void select_many(const std::vector<int>& ranks,std::vector<T>& out) {
+        out.resize(ranks.size());
+        for(std::size_t i=0;i<ranks.size();i++) out[i] = *find_by_order(ranks[i]);
+    }
+
+    /**
+     * out[i] = order_of_key(keys[i]), keys must be sorted by Comp
+     */
+    void rank_many(const std::vector<T>& keys,std::vector<int>& out) {
+        out.resize(keys.size());
+        for(std::size_t i=0;i<keys.size();i++) out[i] = order_of_key(keys[i]);
+    }
+
+    ~MappedRBTree() {
+        close();
+    }
+};
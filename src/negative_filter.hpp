@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Blocked counting Bloom filter shared by the tree headers, answers
+ * "definitely absent" for most keys that are not in the tree without
+ * walking it.
+ *
+ * The filter is split into blocks of 64 one byte counters (one cache line)
+ * and all PROBES counters of a key are in the same block, so a query reads
+ * one or two cache lines. Counters make erase possible: add increments the
+ * key's counters and remove decrements them. A counter that reaches 255
+ * stays at 255, which can only cost false positives, never false negatives.
+ *
+ * The hash is a std::function so that trees of keys without std::hash
+ * only need one when they enable the filter.
+ */
+template<class T>
+class negative_filter {
+    static const int BLOCK = 64;
+    static const int PROBES = 4;
+    static const unsigned char SATURATED = 255;
+
+    std::vector<unsigned char> counters;
+    std::uint64_t num_blocks = 0;
+    std::function<std::size_t(const T&)> hash;
+    std::size_t nonzero = 0;
+
+    unsigned long long num_queries = 0;
+    unsigned long long num_rejected = 0;
+    unsigned long long num_false_positives = 0;
+
+    /**
+     * the block of key, the offsets of its counters come from the low bits
+     */
+    unsigned char* locate(const T& key,std::uint64_t& h) {
+        h = hash(key)*0x9E3779B97F4A7C15ull;
+        h ^= h>>29;
+        std::uint64_t b = ((h>>32)*num_blocks)>>32;
+        return &counters[b*BLOCK];
+    }
+
+    public:
+    bool enabled() const {
+        return num_blocks!=0;
+    }
+
+    /**
+     * uses budget_bytes (rounded down to whole blocks, at least one)
+     * 0 disables the filter
+     * the filter starts empty, keys are added by the tree
+     */
+    void enable(std::size_t budget_bytes,std::function<std::size_t(const T&)> h) {
+        num_blocks = budget_bytes==0 ? 0 : (budget_bytes<BLOCK ? 1 : budget_bytes/BLOCK);
+        counters.assign(num_blocks*BLOCK,0);
+        hash = h;
+        nonzero = 0;
+        reset_stats();
+    }
+
+    /**
+     * forgets every key, keeps the budget and the stats
+     */
+    void clear() {
+        std::fill(counters.begin(),counters.end(),0);
+        nonzero = 0;
+    }
+
+    void add(const T& key) {
+        if(!enabled()) return;
+        std::uint64_t h;
+        unsigned char* block = locate(key,h);
+        for(int i=0;i<PROBES;i++,h>>=6) {
+            unsigned char& c = block[h&(BLOCK-1)];
+            if(c==0) nonzero++;
+            if(c!=SATURATED) c++;
+        }
+    }
+
+    /**
+     * key must have been added
+     */
+    void remove(const T& key) {
+        if(!enabled()) return;
+        std::uint64_t h;
+        unsigned char* block = locate(key,h);
+        for(int i=0;i<PROBES;i++,h>>=6) {
+            unsigned char& c = block[h&(BLOCK-1)];
+            if(c!=SATURATED && --c==0) nonzero--;
+        }
+    }
+
+    /**
+     * false means key is definitely not in the tree
+     */
+    bool may_contain(const T& key) {
+        num_queries++;
+        std::uint64_t h;
+        const unsigned char* block = locate(key,h);
+        for(int i=0;i<PROBES;i++,h>>=6) {
+            if(block[h&(BLOCK-1)]==0) {
+                num_rejected++;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * the tree reports a key that passed may_contain but was absent
+     */
+    void false_positive() {
+        num_false_positives++;
+    }
+
+    void reset_stats() {
+        num_queries = num_rejected = num_false_positives = 0;
+    }
+
+    unsigned long long queries() const {
+        return num_queries;
+    }
+
+    /**
+     * queries answered "definitely absent" without touching the tree
+     */
+    unsigned long long rejected() const {
+        return num_rejected;
+    }
+
+    /**
+     * queries that passed the filter and then missed in the tree
+     */
+    unsigned long long false_positives() const {
+        return num_false_positives;
+    }
+
+    /**
+     * measured fraction of absent keys that got through
+     */
+    double false_positive_rate() const {
+        unsigned long long absent = num_rejected+num_false_positives;
+        return absent==0 ? 0.0 : (double)num_false_positives/absent;
+    }
+
+    /**
+     * expected false positive rate for the current contents, from the
+     * fraction of nonzero counters, ignoring the variance between blocks
+     */
+    double estimated_false_positive_rate() const {
+        if(!enabled()) return 1.0;
+        double fill = (double)nonzero/counters.size();
+        double p = 1.0;
+        for(int i=0;i<PROBES;i++) p *= fill;
+        return p;
+    }
+
+    std::size_t memory_usage() const {
+        return counters.size();
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+
+/**
+ * Helpers shared by the tree headers for parallel in-order traversal.
+ * Every node knows the size of its subtree, so the in-order sequence can be
+ * cut into contiguous rank ranges of equal length without a traversal,
+ * and each range is then walked with successor on its own thread.
+ *
+ * node must have child[2] (left, right) and size fields, NILL terminated.
+ */
+
+/**
+ * Number of rank ranges used for n keys on num_threads threads
+ * num_threads = 0 means std::thread::hardware_concurrency()
+ * small trees are not worth a thread per range
+ */
+inline unsigned parallel_rank_chunks(int n,unsigned num_threads) {
+    const int min_chunk = 4096;
+    if(num_threads==0) num_threads = std::thread::hardware_concurrency();
+    if(num_threads==0) num_threads = 1;
+    unsigned chunks = n/min_chunk;
+    if(chunks>num_threads) chunks = num_threads;
+    if(chunks==0) chunks = 1;
+    return chunks;
+}
+
+/**
+ * Finds the kth smallest node (0 indexed) without restructuring the tree
+ * k must be smaller than the size of the subtree rooted at x
+ */
+template<class node>
+node* select_node(node* x,int k) {
+    while(true) {
+        if(x->child[0]->size>k) x = x->child[0];
+        else if(x->child[0]->size==k) return x;
+        else {
+            k -= x->child[0]->size+1;
+            x = x->child[1];
+        }
+    }
+}
+
+/**
+ * Splits the keys of the tree rooted at root into chunks rank ranges of
+ * (almost) equal length and calls f(chunk,first,count) for every range,
+ * range 0 on the calling thread and the others on their own threads.
+ * select(k) must return the node of rank k, e.g. select_node(root,k).
+ * The tree must not be modified until it returns.
+ */
+template<class node,class Select,class F>
+void parallel_rank_ranges(node* root,unsigned chunks,Select select,F f) {
+    int n = root->size;
+    if(n==0) return;
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunks-1);
+    for(unsigned c=1;c<chunks;c++) {
+        int first = (long long)n*c/chunks;
+        int last = (long long)n*(c+1)/chunks;
+        workers.emplace_back([=,&select,&f]() {
+            f(c,select(first),last-first);
+        });
+    }
+
+    f(0u,select(0),(int)((long long)n/chunks));
+
+    for(std::thread& worker : workers) worker.join();
+}
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * Helpers shared by the tree headers for moving their nodes into one
+ * contiguous block in a cache friendly order (defragmentation).
+ * After many inserts and erases the nodes are scattered over the heap and
+ * every level of a descent is a cache (and TLB) miss of its own. A
+ * relayout pass moves the nodes, shape, augmentation and all, into a
+ * freshly allocated block:
+ * - van_emde_boas: the tree is cut at half its height, the top tree is
+ *   laid out first and then every bottom tree, each of them recursively,
+ *   so a descent touches O(log_B n) blocks for every block size B at once
+ *   (cache lines, pages) without knowing B
+ * - breadth_first: level order, the top levels that every descent goes
+ *   through share a handful of cache lines
+ *
+ * A pass plans the order with one read only traversal, then moves the
+ * nodes a bounded number at a time, so it can run behind live traffic.
+ * Inserts, erases and rotations may happen between the steps: new nodes
+ * stay where the allocator put them until the next pass, and erased nodes
+ * that still wait to be moved are only freed when the pass ends.
+ *
+ * node must have child[2] (left, right) and parent fields, NILL terminated,
+ * and be move constructible. A node with a null parent is never part of a
+ * tree (the root's parent is NILL), that is how erased nodes are marked.
+ */
+
+enum relayout_policy {van_emde_boas,breadth_first};
+
+/**
+ * appends the nodes of the tree rooted at root to out in level order
+ */
+template<class node>
+void breadth_first_order(node* root,node* nill,std::vector<node*>& out) {
+    if(root==nill) return;
+    out.push_back(root);
+    for(std::size_t i=out.size()-1;i<out.size();i++) {
+        node* x = out[i];
+        if(x->child[0]!=nill) out.push_back(x->child[0]);
+        if(x->child[1]!=nill) out.push_back(x->child[1]);
+    }
+}
+
+/**
+ * appends the nodes of the tree rooted at root to out in van Emde Boas order
+ * the levels are those of the whole tree, so in an unbalanced (splay)
+ * tree every bottom tree is cut at the same depths as in a complete one
+ * an explicit stack is used to walk the top trees, the recursion itself
+ * is only O(log height) deep
+ */
+template<class node>
+void van_emde_boas_order(node* root,node* nill,std::vector<node*>& out) {
+    struct layout {
+        node* nill;
+        std::vector<node*>& out;
+        std::vector<node*> bottoms{}; // roots of the bottom trees, shared by the recursion
+        std::vector<std::pair<node*,int>> stack{};
+
+        /**
+         * appends the nodes less than h levels below x
+         */
+        void lay_out(node* x,int h) {
+            if(h==1) {
+                out.push_back(x);
+                return;
+            }
+
+            int top = h/2;
+            lay_out(x,top);
+
+            // the nodes exactly top levels below x, from left to right
+            std::size_t begin = bottoms.size();
+            stack.push_back({x,0});
+            while(!stack.empty()) {
+                std::pair<node*,int> f = stack.back();
+                stack.pop_back();
+                if(f.second==top) {
+                    bottoms.push_back(f.first);
+                    continue;
+                }
+                if(f.first->child[1]!=nill) stack.push_back({f.first->child[1],f.second+1});
+                if(f.first->child[0]!=nill) stack.push_back({f.first->child[0],f.second+1});
+            }
+
+            std::size_t end = bottoms.size();
+            for(std::size_t i=begin;i<end;i++) lay_out(bottoms[i],h-top);
+            bottoms.resize(begin);
+        }
+    };
+
+    if(root==nill) return;
+
+    int height = 0;
+    std::vector<std::pair<node*,int>> stack{{root,1}};
+    while(!stack.empty()) {
+        std::pair<node*,int> f = stack.back();
+        stack.pop_back();
+        if(f.second>height) height = f.second;
+        if(f.first->child[0]!=nill) stack.push_back({f.first->child[0],f.second+1});
+        if(f.first->child[1]!=nill) stack.push_back({f.first->child[1],f.second+1});
+    }
+
+    layout l{nill,out};
+    l.lay_out(root,height);
+}
+
+/**
+ * Owns the blocks filled by relayout passes and runs the pending pass.
+ * Nodes outside the blocks were allocated with new, release frees a node
+ * of either kind, so trees call it wherever they used to delete a node.
+ * A block is freed once its last node is released. Blocks are shared
+ * between the trees nodes move to (splay_tree::split / join), the count
+ * of live nodes in a block is atomic so those trees can still be used
+ * from different threads.
+ */
+template<class node>
+class node_arena {
+    struct block {
+        node* begin;
+        std::size_t capacity;
+        std::atomic<std::size_t> live{0};
+
+        explicit block(std::size_t capacity) : begin(std::allocator<node>().allocate(capacity)), capacity(capacity) {}
+
+        ~block() {
+            std::allocator<node>().deallocate(begin,capacity);
+        }
+
+        bool contains(node* x) {
+            return !std::less<node*>()(x,begin) && std::less<node*>()(x,begin+capacity);
+        }
+    };
+
+    std::vector<std::shared_ptr<block>> blocks;
+
+    std::vector<node*> plan; // the pass in progress, nodes still to move from plan[next] on
+    std::size_t next = 0;
+    std::shared_ptr<block> target;
+    std::vector<node*> erased; // released during the pass, freed when it ends
+
+    void free_node(node* x) {
+        for(std::size_t i=0;i<blocks.size();i++) {
+            if(!blocks[i]->contains(x)) continue;
+            x->~node();
+            if(--blocks[i]->live==0 && blocks[i]!=target) blocks.erase(blocks.begin()+i);
+            return;
+        }
+        delete x;
+    }
+
+    /**
+     * the target of a pass is kept while it fills up, and another tree
+     * can release the last node of a shared block
+     */
+    void drop_empty_blocks() {
+        blocks.erase(std::remove_if(blocks.begin(),blocks.end(),[](const std::shared_ptr<block>& b) {
+            return b->live==0;
+        }),blocks.end());
+    }
+
+    void end_pass() {
+        for(node* x : erased) free_node(x);
+        std::vector<node*>().swap(erased);
+        std::vector<node*>().swap(plan);
+        next = 0;
+        target.reset();
+        drop_empty_blocks();
+    }
+
+    public:
+    node_arena() {}
+    node_arena(const node_arena&) = delete;
+    node_arena& operator=(const node_arena&) = delete;
+
+    /**
+     * frees a node that was unlinked from the tree
+     * during a pass a node that may still be in the plan is only marked
+     */
+    void release(node* x) {
+        if(target && !target->contains(x)) {
+            x->parent = nullptr;
+            erased.push_back(x);
+            return;
+        }
+        free_node(x);
+    }
+
+    /**
+     * plans a pass over the tree rooted at root, abandoning the pending one
+     * O(n) time and n pointers of scratch, nothing is moved yet
+     */
+    void begin(node* root,node* nill,relayout_policy policy) {
+        end_pass();
+        if(policy==van_emde_boas) van_emde_boas_order(root,nill,plan);
+        else breadth_first_order(root,nill,plan);
+        if(plan.empty()) return;
+
+        target = std::make_shared<block>(plan.size());
+        blocks.push_back(target);
+    }
+
+    /**
+     * moves up to max_nodes more nodes of the pending pass into the block,
+     * relinking their parents and children, and returns whether the
+     * pass is complete
+     */
+    bool step(node*& root,node* nill,std::size_t max_nodes) {
+        for(;max_nodes>0 && next<plan.size();max_nodes--,next++) {
+            node* x = plan[next];
+            if(x->parent==nullptr) continue; // erased, freed with the pass
+
+            node* y = new(target->begin+next) node(std::move(*x));
+            target->live++;
+            for(int d=0;d<2;d++) {
+                if(y->child[d]!=nill) y->child[d]->parent = y;
+            }
+            if(y->parent==nill) root = y;
+            else y->parent->child[y->parent->child[1]==x] = y;
+
+            free_node(x);
+        }
+
+        if(next<plan.size()) return false;
+        end_pass();
+        return true;
+    }
+
+    bool pending() {
+        return target!=nullptr;
+    }
+
+    /**
+     * after nodes moved from other to this tree, e.g. a splay_tree
+     * split or join, this arena also frees the ones in other's blocks
+     * both pending passes are abandoned
+     */
+    void share(node_arena& other) {
+        end_pass();
+        other.end_pass();
+        for(const std::shared_ptr<block>& b : other.blocks) {
+            if(std::find(blocks.begin(),blocks.end(),b)==blocks.end()) blocks.push_back(b);
+        }
+    }
+
+    /**
+     * forgets the blocks once every node of the tree moved elsewhere
+     */
+    void clear() {
+        end_pass();
+        blocks.clear();
+    }
+
+    /**
+     * bytes of the blocks referenced, including the slots of nodes that
+     * were released or never filled
+     */
+    std::size_t block_bytes() {
+        std::size_t bytes = 0;
+        for(const std::shared_ptr<block>& b : blocks) bytes += b->capacity*sizeof(node);
+        return bytes;
+    }
+
+    /**
+     * live nodes in the blocks referenced, of every tree sharing them
+     */
+    std::size_t block_nodes() {
+        std::size_t count = 0;
+        for(const std::shared_ptr<block>& b : blocks) count += b->live;
+        return count;
+    }
+
+    bool in_block(node* x) {
+        for(const std::shared_ptr<block>& b : blocks) {
+            if(b->contains(x)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * the plan of the pending pass and the nodes erased during it
+     */
+    std::size_t scratch_bytes() {
+        return (plan.capacity()+erased.capacity())*sizeof(node*) + erased.size()*sizeof(node);
+    }
+
+    ~node_arena() {
+        end_pass();
+    }
+};
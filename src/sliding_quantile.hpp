@@ -0,0 +1,407 @@
+#pragma once
+
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Node storage shared by sliding_quantile windows
+ * Nodes are carved out of chunks and recycled through a free list, so a
+ * value expiring from one stream frees a node the next stream can use and
+ * thousands of small windows don't each go through the allocator.
+ * The pool must outlive every window using it.
+ */
+template<class T>
+class quantile_node_pool {
+	public:
+	struct node {
+		T key;
+		int count = 0; // multiplicity of key
+		int size = 0;  // sum of the counts in the subtree
+		int height = -1;
+		node* child[2]; // left, right
+
+		node() : child{this,this} {}
+	};
+
+	static node NULL_NODE;
+	static node* NILL;
+
+	private:
+	static const int CHUNK = 1024;
+
+	std::vector<std::unique_ptr<node[]>> chunks;
+	node* free_list = nullptr;
+	int used_in_last = CHUNK;
+	int live = 0;
+
+	public:
+	quantile_node_pool() {}
+	quantile_node_pool(const quantile_node_pool&) = delete;
+	quantile_node_pool& operator=(const quantile_node_pool&) = delete;
+
+	node* allocate(const T& key,int count) {
+		node* x;
+		if(free_list!=nullptr) {
+			x = free_list;
+			free_list = x->child[0];
+		} else {
+			if(used_in_last==CHUNK) {
+				chunks.emplace_back(new node[CHUNK]);
+				used_in_last = 0;
+			}
+			x = &chunks.back()[used_in_last++];
+		}
+
+		x->key = key;
+		x->count = count;
+		x->size = count;
+		x->height = 0;
+		x->child[0] = x->child[1] = NILL;
+		live++;
+		return x;
+	}
+
+	void release(node* x) {
+		x->child[0] = free_list;
+		free_list = x;
+		live--;
+	}
+
+	/**
+	 * nodes currently in use by some window
+	 */
+	int nodes_in_use() {
+		return live;
+	}
+
+	/**
+	 * nodes ever carved out of chunks, in use or free
+	 */
+	int nodes_reserved() {
+		return (int)chunks.size()*CHUNK-(CHUNK-used_in_last);
+	}
+};
+
+template<class T>
+typename quantile_node_pool<T>::node quantile_node_pool<T>::NULL_NODE = {};
+
+
+template<class T>
+typename quantile_node_pool<T>::node* quantile_node_pool<T>::NILL = &quantile_node_pool<T>::NULL_NODE;
+
+
+/**
+ * sliding_quantile Class
+ * Quantiles over the last max_events events and/or the events of the last
+ * max_age time units of a stream.
+ *
+ * The window is an AVL tree with one node per distinct value holding its
+ * multiplicity, sizes are sums of multiplicities, so find_by_order and
+ * order_of_key count events, not distinct values. Arrival order is kept in
+ * a FIFO of runs (value, count, time): consecutive equal values pushed at
+ * the same time share a run, and expiry works on whole runs, so a burst of
+ * duplicates costs one tree update to add and one to expire.
+ * push, expiry per run, find_by_order and order_of_key are O(log d)
+ * for d distinct values in the window.
+ */
+template<class T,typename Comp = std::less<T>>
+class sliding_quantile {
+	typedef quantile_node_pool<T> pool_t;
+	typedef typename pool_t::node node;
+
+	struct run {
+		T value;
+		int count;
+		long long time;
+	};
+
+	Comp comp;
+
+	std::unique_ptr<pool_t> own_pool;
+	pool_t* pool;
+	node* root = pool_t::NILL;
+	std::deque<run> fifo;
+
+	int max_events;
+	long long max_age;
+
+
+	static inline int max(int a,int b) {
+		if(a>b) return a;
+		return b;
+	}
+
+	static inline void relax_augmentation(node* x) {
+		x->height = max(x->child[0]->height,x->child[1]->height)+1;
+		x->size = x->child[0]->size + x->child[1]->size + x->count;
+	}
+
+	/**
+	 * rotates x down to side d (0 left, 1 right), its child on the other
+	 * side, which must not be NILL, takes its place
+	 * returns the new subtree root
+	 */
+	static node* single_rotate(node* x,int d) {
+		node* y = x->child[!d];
+		x->child[!d] = y->child[d];
+		y->child[d] = x;
+		relax_augmentation(x);
+		relax_augmentation(y);
+		return y;
+	}
+
+	/**
+	 * fixes the augmentation of x and an avl violation at x
+	 * returns the new subtree root
+	 */
+	static node* rebalance(node* x) {
+		int hl = x->child[0]->height;
+		int hr = x->child[1]->height;
+		if(hr>hl+1 || hl>hr+1) {
+			// x is too high on side !d, it goes down to side d
+			// with a double rotation when the inner grandchild is the higher one
+			int d = hl>hr;
+			node* c = x->child[!d];
+			if(c->child[d]->height>c->child[!d]->height) x->child[!d] = single_rotate(c,!d);
+			return single_rotate(x,d);
+		}
+		relax_augmentation(x);
+		return x;
+	}
+
+	/**
+	 * adds count copies of val to the subtree rooted at x
+	 */
+	node* insert(node* x,const T& val,int count) {
+		if(x==pool_t::NILL) return pool->allocate(val,count);
+		if(comp(val,x->key)) x->child[0] = insert(x->child[0],val,count);
+		else if(comp(x->key,val)) x->child[1] = insert(x->child[1],val,count);
+		else {
+			x->count += count;
+			x->size += count;
+			return x;
+		}
+		return rebalance(x);
+	}
+
+	/**
+	 * unlinks the smallest node of the subtree rooted at x into m
+	 */
+	static node* remove_min(node* x,node*& m) {
+		if(x->child[0]==pool_t::NILL) {
+			m = x;
+			return x->child[1];
+		}
+		x->child[0] = remove_min(x->child[0],m);
+		return rebalance(x);
+	}
+
+	/**
+	 * removes count copies of val from the subtree rooted at x
+	 * val must be there at least count times
+	 */
+	node* remove(node* x,const T& val,int count) {
+		if(comp(val,x->key)) x->child[0] = remove(x->child[0],val,count);
+		else if(comp(x->key,val)) x->child[1] = remove(x->child[1],val,count);
+		else if(x->count>count) {
+			x->count -= count;
+			x->size -= count;
+			return x;
+		} else {
+			node* r;
+			if(x->child[0]==pool_t::NILL) r = x->child[1];
+			else if(x->child[1]==pool_t::NILL) r = x->child[0];
+			else {
+				node* m;
+				node* right = remove_min(x->child[1],m);
+				m->child[0] = x->child[0];
+				m->child[1] = right;
+				r = rebalance(m);
+			}
+			pool->release(x);
+			return r;
+		}
+		return rebalance(x);
+	}
+
+	void erase_sub_tree(node* x) {
+		if(x==pool_t::NILL) return;
+		erase_sub_tree(x->child[0]);
+		erase_sub_tree(x->child[1]);
+		pool->release(x);
+	}
+
+	/**
+	 * drops the oldest events beyond max_events
+	 */
+	void expire_count() {
+		if(max_events<=0) return;
+		int excess = root->size-max_events;
+		while(excess>0) {
+			run& r = fifo.front();
+			int take = r.count<excess ? r.count : excess;
+			root = remove(root,r.value,take);
+			excess -= take;
+			r.count -= take;
+			if(r.count==0) fifo.pop_front();
+		}
+	}
+
+	public:
+	/**
+	 * max_events <= 0 disables the event limit, max_age < 0 the time limit
+	 * with a pool the nodes come from (and go back to) the shared pool
+	 */
+	explicit sliding_quantile(int max_events,long long max_age = -1,pool_t* shared_pool = nullptr) :
+	own_pool(shared_pool==nullptr ? new pool_t() : nullptr),
+	pool(shared_pool==nullptr ? own_pool.get() : shared_pool),
+	max_events(max_events), max_age(max_age) {}
+
+	sliding_quantile(const sliding_quantile&) = delete;
+	sliding_quantile& operator=(const sliding_quantile&) = delete;
+
+	/**
+	 * adds count copies of val at time, times must not decrease,
+	 * then expires what fell out of the window
+	 */
+	void push(const T& val,long long time = 0,int count = 1) {
+		if(!fifo.empty() && fifo.back().time==time && !comp(fifo.back().value,val) && !comp(val,fifo.back().value)) {
+			fifo.back().count += count;
+		} else {
+			fifo.push_back({val,count,time});
+		}
+		root = insert(root,val,count);
+
+		expire(time);
+		expire_count();
+	}
+
+	/**
+	 * drops every event at or before now-max_age, a whole run per tree update
+	 */
+	void expire(long long now) {
+		if(max_age<0) return;
+		while(!fifo.empty() && fifo.front().time<=now-max_age) {
+			root = remove(root,fifo.front().value,fifo.front().count);
+			fifo.pop_front();
+		}
+	}
+
+	/**
+	 * the kth smallest event, duplicates counted
+	 * 0 <= k < size()
+	 */
+	const T& find_by_order(int k) {
+		node* x = root;
+		while(true) {
+			if(x->child[0]->size>k) x = x->child[0];
+			else if(x->child[0]->size+x->count>k) return x->key;
+			else {
+				k -= x->child[0]->size+x->count;
+				x = x->child[1];
+			}
+		}
+	}
+
+	/**
+	 * number of events smaller than val
+	 */
+	int order_of_key(const T& val) {
+		node* x = root;
+		int p = 0;
+		while(x!=pool_t::NILL) {
+			if(comp(x->key,val)) {
+				p += x->child[0]->size+x->count;
+				x = x->child[1];
+			} else {
+				x = x->child[0];
+			}
+		}
+		return p;
+	}
+
+	/**
+	 * nearest rank quantile: the ceil(q*size())th smallest event,
+	 * q in [0,1], the window must not be empty
+	 * quantile(0.5) is the (lower) median, quantile(1) the maximum
+	 */
+	const T& quantile(double q) {
+		int k = (int)std::ceil(q*root->size-1e-9)-1; // q*size() may be off by a rounding error
+		if(k<0) k = 0;
+		if(k>=root->size) k = root->size-1;
+		return find_by_order(k);
+	}
+
+	void clear() {
+		erase_sub_tree(root);
+		root = pool_t::NILL;
+		fifo.clear();
+	}
+
+	/**
+	 * events in the window, duplicates counted
+	 */
+	int size() {
+		return root->size;
+	}
+
+	bool empty() {
+		return root->size==0;
+	}
+
+	~sliding_quantile() {
+		erase_sub_tree(root);
+	}
+};
+
+
+/**
+ * sliding_quantile_streams Class
+ * Many sliding_quantile windows with the same limits, numbered from 0,
+ * sharing one node pool.
+ */
+template<class T,typename Comp = std::less<T>>
+class sliding_quantile_streams {
+	quantile_node_pool<T> pool; // declared first, destroyed after the windows
+	std::deque<sliding_quantile<T,Comp>> windows;
+	int max_events;
+	long long max_age;
+
+	public:
+	explicit sliding_quantile_streams(int max_events,long long max_age = -1) :
+	max_events(max_events), max_age(max_age) {}
+
+	/**
+	 * the window of stream id, created (with all ids below it) on first use
+	 */
+	sliding_quantile<T,Comp>& stream(unsigned id) {
+		while(windows.size()<=id) windows.emplace_back(max_events,max_age,&pool);
+		return windows[id];
+	}
+
+	void push(unsigned id,const T& val,long long time = 0,int count = 1) {
+		stream(id).push(val,time,count);
+	}
+
+	const T& quantile(unsigned id,double q) {
+		return stream(id).quantile(q);
+	}
+
+	/**
+	 * expires old events in every stream, also the idle ones
+	 */
+	void expire(long long now) {
+		for(sliding_quantile<T,Comp>& w : windows) w.expire(now);
+	}
+
+	unsigned streams() {
+		return windows.size();
+	}
+
+	quantile_node_pool<T>& node_pool() {
+		return pool;
+	}
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <iostream>
+
+#include "splay_sequence.hpp"
+
+/**
+ * splay Range Sequence Class
+ * splay_sequence with lazy range updates and subtree aggregates.
+ *
+ * Every node keeps the sum, min and max of its subtree. A range update on
+ * positions [first,last) splays the neighbours of the range so that the
+ * range becomes one subtree, applies the update to the subtree root only
+ * and leaves a tag there that is pushed down to the children the next time
+ * a search passes through the node. All operations are O(log n) amortized.
+ *
+ * Tag convention: a node's own value and aggregates already include its
+ * tags, the tags only describe what still has to be applied to its children.
+ * The splay_sequence underneath pushes the nodes on the way down, so
+ * everything splay rotates is clean.
+ *
+ * T must support +, < and multiplication by an int count.
+ */
+
+/**
+ * node of splay_range_sequence, NILL is the only node of size 0
+ */
+template<class T>
+struct splay_range_node {
+	T value;
+	T sum;
+	T min;
+	T max;
+	int size = 0;
+	bool rev = false;
+	bool has_assign = false;
+	T assign_tag;
+	T add_tag;
+	splay_range_node* child[2];
+	splay_range_node* parent;
+
+	splay_range_node(const T& value,splay_range_node* left,splay_range_node* right,splay_range_node* parent) :
+	value(value), sum(value), min(value), max(value), size(1), assign_tag(), add_tag(),
+	child{left,right}, parent(parent) {}
+
+	splay_range_node() : value(), sum(), min(), max(), assign_tag(), add_tag(),
+	child{this,this},parent(this) {}
+
+	/**
+	 * children of x must have valid aggregates
+	 */
+	static void relax(splay_range_node* x) {
+		x->size = x->child[0]->size + x->child[1]->size + 1;
+		x->sum = x->value;
+		x->min = x->value;
+		x->max = x->value;
+		splay_range_node* l = x->child[0];
+		splay_range_node* r = x->child[1];
+		if(l->size) {
+			x->sum = l->sum + x->sum;
+			if(l->min < x->min) x->min = l->min;
+			if(x->max < l->max) x->max = l->max;
+		}
+		if(r->size) {
+			x->sum = x->sum + r->sum;
+			if(r->min < x->min) x->min = r->min;
+			if(x->max < r->max) x->max = r->max;
+		}
+	}
+
+	/**
+	 * reverses the subtree rooted at x
+	 */
+	static void apply_reverse(splay_range_node* x) {
+		if(x->size==0) return;
+		splay_range_node* t = x->child[0];
+		x->child[0] = x->child[1];
+		x->child[1] = t;
+		x->rev = !x->rev;
+	}
+
+	/**
+	 * sets every value in the subtree rooted at x to v
+	 */
+	static void apply_assign(splay_range_node* x,const T& v) {
+		if(x->size==0) return;
+		x->value = v;
+		x->sum = v*x->size;
+		x->min = v;
+		x->max = v;
+		x->has_assign = true;
+		x->assign_tag = v;
+		x->add_tag = T();
+	}
+
+	/**
+	 * adds d to every value in the subtree rooted at x
+	 */
+	static void apply_add(splay_range_node* x,const T& d) {
+		if(x->size==0) return;
+		x->value = x->value + d;
+		x->sum = x->sum + d*x->size;
+		x->min = x->min + d;
+		x->max = x->max + d;
+		if(x->has_assign) x->assign_tag = x->assign_tag + d;
+		else x->add_tag = x->add_tag + d;
+	}
+
+	/**
+	 * pushes the pending tags of x down to its children
+	 */
+	static void push(splay_range_node* x) {
+		if(x->rev) {
+			apply_reverse(x->child[0]);
+			apply_reverse(x->child[1]);
+			x->rev = false;
+		}
+		if(x->has_assign) {
+			apply_assign(x->child[0],x->assign_tag);
+			apply_assign(x->child[1],x->assign_tag);
+			x->has_assign = false;
+		} else if(!(x->add_tag==T())) {
+			apply_add(x->child[0],x->add_tag);
+			apply_add(x->child[1],x->add_tag);
+		}
+		x->add_tag = T();
+	}
+};
+
+template<class T>
+class splay_range_sequence : splay_sequence<T,splay_range_node<T>> {
+	typedef splay_range_node<T> node;
+	typedef splay_sequence<T,node> base;
+
+	using base::NILL;
+	using base::root;
+	using base::relax_augmentation;
+	using base::select;
+
+	/**
+	 * in order traversal that pushes tags on the way
+	 */
+	template<class F>
+	void for_each(node* x,F& f) {
+		if(x==NILL) return;
+		node::push(x);
+		for_each(x->child[0],f);
+		f(static_cast<const T&>(x->value));
+		for_each(x->child[1],f);
+	}
+
+	/**
+	 * brings the elements at positions [first,last) into a single subtree
+	 * and returns its root, first < last
+	 * the node before the range is splayed to the root and the node after
+	 * it to the right child of the root, the range is what lies between
+	 */
+	node* isolate(int first,int last) {
+		int n = size();
+		if(first==0 && last==n) return root;
+		if(first==0) return select(last)->child[0];
+		if(last==n) return select(first-1)->child[1];
+
+		node* before = select(first-1);
+		return select(last,before)->child[0];
+	}
+
+	/**
+	 * fixes the augmentation of the (at most two) ancestors of x
+	 * after x was updated
+	 */
+	void relax_ancestors(node* x) {
+		for(node* y = x->parent;y!=NILL;y=y->parent) relax_augmentation(y);
+	}
+
+	public:
+	using base::insert_at;
+	using base::push_back;
+	using base::erase_at;
+	using base::clear;
+	using base::empty;
+	using base::size;
+
+	/**
+	 * element at position pos
+	 * 0 <= pos < size()
+	 */
+	T at(int pos) {
+		return select(pos)->value;
+	}
+
+	/**
+	 * keeps the first pos elements and moves the rest to the (cleared) sequence right
+	 * O(log n) amortized
+	 */
+	void split_at(int pos,splay_range_sequence<T>& right) {
+		base::split_at(pos,right);
+	}
+
+	/**
+	 * appends all elements of other, other becomes empty
+	 * O(log n) amortized
+	 */
+	void concat(splay_range_sequence<T>& other) {
+		base::concat(other);
+	}
+
+	/**
+	 * reverses the elements at positions [first,last)
+	 */
+	void reverse(int first,int last) {
+		if(first>=last) return;
+		node* x = isolate(first,last);
+		node::apply_reverse(x);
+		relax_ancestors(x);
+	}
+
+	/**
+	 * adds d to the elements at positions [first,last)
+	 */
+	void add(int first,int last,const T& d) {
+		if(first>=last) return;
+		node* x = isolate(first,last);
+		node::apply_add(x,d);
+		relax_ancestors(x);
+	}
+
+	/**
+	 * sets the elements at positions [first,last) to v
+	 */
+	void assign(int first,int last,const T& v) {
+		if(first>=last) return;
+		node* x = isolate(first,last);
+		node::apply_assign(x,v);
+		relax_ancestors(x);
+	}
+
+	/**
+	 * sum of the elements at positions [first,last), first < last
+	 */
+	T sum(int first,int last) {
+		return isolate(first,last)->sum;
+	}
+
+	/**
+	 * minimum of the elements at positions [first,last), first < last
+	 */
+	T min(int first,int last) {
+		return isolate(first,last)->min;
+	}
+
+	/**
+	 * maximum of the elements at positions [first,last), first < last
+	 */
+	T max(int first,int last) {
+		return isolate(first,last)->max;
+	}
+
+	/**
+	 * calls f(value) on every element in order, O(n)
+	 */
+	template<class F>
+	void for_each(F f) {
+		for_each(root,f);
+	}
+};
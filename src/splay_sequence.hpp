@@ -0,0 +1,317 @@
+#pragma once
+
+#include <iostream>
+
+#include "balancing.hpp"
+
+/**
+ * splay Sequence Class
+ * A sequence with O(log n) amortized positional access, insertion and erasure.
+ *
+ * Same engine as splay_tree (balancing.hpp), but the nodes are ordered by
+ * position instead of by key: the size augmentation alone locates an
+ * element, no comparisons are made. Every positional access splays the
+ * element to the root, so split_at and concat only relink the root.
+ *
+ * The node type carries the augmentation, splay_range_sequence builds on
+ * this class with nodes that also keep aggregates and lazy tags. A node
+ * type has a value, size (0 only on NILL), child[2] and parent, a
+ * (value,left,right,parent) constructor, a default one for NILL, and two
+ * hooks: relax(x) recomputes the augmentation of x from its children and
+ * push(x) hands pending lazy updates of x down to its children. Every node
+ * on the way down of a search is pushed, so everything splay rotates is
+ * clean.
+ */
+
+/**
+ * node of splay_sequence, augmented with the subtree size only
+ */
+template<class T>
+struct splay_sequence_node {
+	T value;
+	int size = 0;
+	splay_sequence_node* child[2];
+	splay_sequence_node* parent;
+
+	splay_sequence_node(const T& value,splay_sequence_node* left,splay_sequence_node* right,splay_sequence_node* parent) :
+	value(value), size(1), child{left,right}, parent(parent) {}
+
+	splay_sequence_node() : child{this,this},parent(this) {}
+
+	static void relax(splay_sequence_node* x) {
+		x->size = x->child[0]->size + x->child[1]->size + 1;
+	}
+
+	static void push(splay_sequence_node*) {}
+};
+
+template<class T,class node = splay_sequence_node<T>>
+class splay_sequence {
+	static node* successor(node* x) {
+		if(x->child[1]!=NILL) {
+			x=x->child[1];
+			while(x->child[0]!=NILL) x=x->child[0];
+			return x;
+		}
+
+		node* y = x->parent;
+		while(y!=NILL && y->child[1]==x) {
+			x = y;
+			y = x->parent;
+		}
+
+		return y;
+	}
+
+	static node* predecessor(node* x) {
+		if(x->child[0]!=NILL) {
+			x=x->child[0];
+			while(x->child[1]!=NILL) {
+				x=x->child[1];
+			}
+			return x;
+		}
+
+		node* y = x->parent;
+		while(y!=NILL && y->child[0]==x) {
+			x = y;
+			y = x->parent;
+		}
+
+		return y;
+	}
+
+
+	/**
+	 * private helper function
+	 * to help destructor to deallocate all memory
+	 * recursively in linear time
+	 */
+	void erase_sub_tree(node* x) {
+		if(x==NILL) return;
+		erase_sub_tree(x->child[0]);
+		erase_sub_tree(x->child[1]);
+		delete x;
+	}
+
+	class iterator {
+		friend class splay_sequence<T,node>;
+		node* it;
+		iterator(node* iter) : it(iter) {}
+		public:
+		iterator() {};
+
+		iterator& operator++() {
+			it = successor(it);
+			return *this;
+		}
+
+		iterator& operator--() {
+			it = predecessor(it);
+			return *this;
+		}
+
+		T& operator*() const {return it->value;}
+		bool operator==(const iterator& rhs) const {return it==rhs.it;}
+		bool operator!=(const iterator& rhs) const {return it!=rhs.it;}
+		iterator& operator=(const iterator& rhs) {
+			it = rhs.it;
+			return *this;
+		}
+
+	};
+
+	protected:
+	static node NULL_NODE;
+	static node* NILL;
+
+	node* root = NILL;
+
+
+	inline void relax_augmentation(node* x) {
+		node::relax(x);
+	}
+
+	/**
+	 * the shared splay engine (balancing.hpp) on this sequence, with
+	 * relax_augmentation as its augmentation hook
+	 */
+	auto engine() {
+		return make_balancer(root,NILL,[this](node* x) {relax_augmentation(x);});
+	}
+
+	/**
+	 * splays x until its parent is goal, by default to the root
+	 * every node on the path from the root to x must be pushed
+	 */
+	void splay(node* x,node* goal = NILL) {
+		engine().splay(x,goal);
+	}
+
+	/**
+	 * Finds the node at position k, pushing on the way down,
+	 * and splays it until its parent is goal, by default to the root
+	 * 0 <= k < root->size, goal must be an ancestor of the node
+	 */
+	node* select(int k,node* goal = NILL) {
+		node* x = root;
+		while(true) {
+			node::push(x);
+			if(x->child[0]->size>k) x = x->child[0];
+			else if(x->child[0]->size==k) break;
+			else {
+				k -= x->child[0]->size+1;
+				x = x->child[1];
+			}
+		}
+
+		splay(x,goal);
+		return x;
+	}
+
+	/**
+	 * splays the last element to the root
+	 * the sequence must not be empty
+	 */
+	void splay_last() {
+		node* x = root;
+		node::push(x);
+		while(x->child[1]!=NILL) {
+			x = x->child[1];
+			node::push(x);
+		}
+		splay(x);
+	}
+
+	public:
+	/**
+	 * inserts val so that it ends up at position pos
+	 * 0 <= pos <= size()
+	 */
+	void insert_at(int pos,const T& val) {
+		node* z = new node(val,NILL,NILL,NILL);
+		if(pos==(int)size()) {
+			z->child[0] = root;
+		} else {
+			node* x = select(pos);
+			z->child[0] = x->child[0];
+			z->child[1] = x;
+			x->child[0] = NILL;
+			x->parent = z;
+			relax_augmentation(x);
+		}
+
+		if(z->child[0]!=NILL) z->child[0]->parent = z;
+		root = z;
+		relax_augmentation(z);
+	}
+
+	void push_back(const T& val) {
+		insert_at(size(),val);
+	}
+
+	/**
+	 * erases the element at position pos
+	 * 0 <= pos < size()
+	 */
+	void erase_at(int pos) {
+		node* z = select(pos);
+		node* l = z->child[0];
+		node* r = z->child[1];
+		delete z;
+
+		if(l==NILL) {
+			root = r;
+			r->parent = NILL;
+			return;
+		}
+
+		root = l;
+		l->parent = NILL;
+		splay_last();
+		root->child[1] = r;
+		if(r!=NILL) r->parent = root;
+		relax_augmentation(root);
+	}
+
+	/**
+	 * element at position pos
+	 * 0 <= pos < size()
+	 */
+	T& at(int pos) {
+		return select(pos)->value;
+	}
+
+	/**
+	 * keeps the first pos elements and moves the rest to the (cleared) sequence right
+	 * O(log n) amortized
+	 */
+	void split_at(int pos,splay_sequence<T,node>& right) {
+		right.clear();
+		if(pos==(int)size()) return;
+
+		node* x = select(pos);
+		right.root = x;
+		root = x->child[0];
+		root->parent = NILL;
+		x->child[0] = NILL;
+		relax_augmentation(x);
+	}
+
+	/**
+	 * appends all elements of other, other becomes empty
+	 * O(log n) amortized
+	 */
+	void concat(splay_sequence<T,node>& other) {
+		if(other.root==NILL) return;
+		if(root==NILL) {
+			root = other.root;
+			other.root = NILL;
+			return;
+		}
+
+		splay_last();
+		root->child[1] = other.root;
+		other.root->parent = root;
+		other.root = NILL;
+		relax_augmentation(root);
+	}
+
+	void clear() {
+		erase_sub_tree(root);
+		root = NILL;
+	}
+
+	bool empty() {
+		return !(root->size);
+	}
+
+	unsigned size() {
+		return root->size;
+	}
+
+	iterator begin() {
+		node* x = root;
+		if(x!=NILL) {
+			while(x->child[0]!=NILL) {
+				x=x->child[0];
+			}
+		}
+		return iterator(x);
+	}
+
+	iterator end() {
+		return iterator(NILL);
+	}
+
+	~splay_sequence() {
+		erase_sub_tree(root);
+	}
+};
+
+template<class T,class node>
+node splay_sequence<T,node>::NULL_NODE = {};
+
+
+template<class T,class node>
+node* splay_sequence<T,node>::NILL = &splay_sequence<T,node>::NULL_NODE;
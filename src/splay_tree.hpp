@@ -1,42 +1,82 @@
+#pragma once
+
 #include <functional>
 #include <iostream>
+#include <random>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "balancing.hpp"
+#include "batch_traversal.hpp"
+#include "negative_filter.hpp"
+#include "parallel_traversal.hpp"
+#include "relayout.hpp"
+#include "tree_stats.hpp"
 
 /**
  * splay Tree Class
  * Can't insert the same key more than once
+ *
+ * Read operations (find, begin, find_by_order, order_of_key) restructure
+ * the tree according to the selected splay_policy:
+ * - full: classic bottom-up splaying of the accessed node to the root
+ * - semi: semi-splaying, roughly halves the depth of the access path
+ *   with about half the rotations, same O(log n) amortized bound
+ * - depth_threshold: splays only when the access path is deeper than
+ *   the configured threshold, shallow accesses do not write to the tree
+ * - randomized: splays each access with probability p
  */
 
 template<class T,typename Comp = std::less<T>>
 class splay_tree {    
+	public:
+	enum splay_policy {full,semi,depth_threshold,randomized};
+
+	private:
 	struct node {    
 		T key;
 		int height = -1;
 		int size = 0;
-		node* left;
-		node* right;
+		node* child[2]; // left, right
 		node* parent;
 
 		node(const T& key,node* left,node* right,node* parent) : key(key), 
-		left(left), right(right), parent(parent), height(0), size(1) {}
+		child{left,right}, parent(parent), height(0), size(1) {}
 
-		node() : left(this),right(this),parent(this) {}   
+		node() : child{this,this},parent(this) {}   
 	};
 
 	Comp comp;
 
+	splay_policy policy = full;
+	int splay_depth_threshold = 0;
+	double splay_probability = 1.0;
+	std::minstd_rand splay_gen;
+	unsigned long long rotation_count = 0;
+
+	/**
+	 * optional filter of the keys, see enable_negative_filter
+	 */ 
+	negative_filter<T> filter;
+
+	/**
+	 * blocks the nodes are moved to by relayout, frees every node
+	 */ 
+	node_arena<node> arena;
+
 	static node NULL_NODE;
 	static node* NILL;
 
 	static node* successor(node* x) {
-		if(x->right!=NILL) {
-			x=x->right;
-			while(x->left!=NILL) x=x->left;
+		if(x->child[1]!=NILL) {
+			x=x->child[1];
+			while(x->child[0]!=NILL) x=x->child[0];
 			return x;
 		}
 
 		node* y = x->parent;
-		while(y!=NILL && y->right==x) {
+		while(y!=NILL && y->child[1]==x) {
 			x = y;
 			y = x->parent;
 		}
@@ -45,16 +85,16 @@ class splay_tree {
 	}
 
 	static node* predecessor(node* x) {
-		if(x->left!=NILL) {
-			x=x->left;
-			while(x->right!=NILL) {
-				x=x->right;
+		if(x->child[0]!=NILL) {
+			x=x->child[0];
+			while(x->child[1]!=NILL) {
+				x=x->child[1];
 			}
 			return x;
 		}
 
-		node* y = y->parent;
-		while(y!=NILL && y->left==x) {
+		node* y = x->parent;
+		while(y!=NILL && y->child[0]==x) {
 			x = y;
 			y = x->parent;
 		}
@@ -70,9 +110,9 @@ class splay_tree {
 	 */ 
 	void erase_sub_tree(node* x) {
 		if(x==NILL) return;
-		erase_sub_tree(x->left);
-		erase_sub_tree(x->right);
-		delete x;
+		erase_sub_tree(x->child[0]);
+		erase_sub_tree(x->child[1]);
+		arena.release(x);
 	}
 
 	class iterator {
@@ -105,29 +145,6 @@ class splay_tree {
 	node* root = NILL;
 
 
-	/**
-	 * A private helper function for the erase method
-	 * replaces subtree rooted at u with subtree rooted at v
-	 * assigns root when necessary
-	 * DOES NOT FIX AUGMENTATION OR PRESERVE AVL PROPERTIES
-	 */ 
-	inline void transplant(node* u,node* v) {
-		if(u->parent==NILL) {
-			root = v;
-		} else if(u->parent->left == u) {
-			u->parent->left = v;
-		} else {
-			u->parent->right = v;
-		}
-
-		if(v!=NILL) {
-			v->parent = u->parent;
-		}
-	}
-
-
-
-
 	/**
 	 * A max function
 	 */ 
@@ -138,148 +155,211 @@ class splay_tree {
 
 
 	inline void relax_augmentation(node* x) {
-		x->height = max(x->left->height,x->right->height)+1;
-		x->size = x->left->size + x->right->size + 1;
+		x->height = max(x->child[0]->height,x->child[1]->height)+1;
+		x->size = x->child[0]->size + x->child[1]->size + 1;
 	}
 
 	/**
-	 * x is not NILL
-	 * x must have a right child
-	 * must adjust root when necessary
-	 * must fix augmentation code locally
+	 * the shared splay engine (balancing.hpp) on this tree, with
+	 * relax_augmentation as its augmentation hook
 	 */ 
-	void single_rotate_left(node* x) {
-		node* y = x->right;
-
-		x->right = y->left;
-		if(x->right!=NILL) x->right->parent = x;
-
-		y->parent = x->parent;
-		if(y->parent==NILL) {
-			root = y;
-		} else if(x == x->parent->left) {
-			y->parent->left = y;
-		} else {
-			y->parent->right = y;
-		}
-
-		y->left = x;
-		x->parent = y;
+	auto engine() {
+		return make_balancer(root,NILL,[this](node* x) {relax_augmentation(x);},&rotation_count);
+	}
 
-		relax_augmentation(x);
-		relax_augmentation(y);
+	void splay(node* x) {
+		engine().splay(x,NILL);
 	}
 
 	/**
-	 * x is not NILL
-	 * x must have a left child
-	 * must adjust root when necessary
-	 * must fix augmentation code locally
+	 * Restructures the tree after a read access to x 
+	 * which was found depth levels below the root
+	 * according to the selected splay policy.
+	 * Callers that need x at the root must use splay instead.
 	 */ 
-	void single_rotate_right(node* x) {
-		node* y = x->left;
-
-		x->left = y->right;
-		if(x->left!=NILL) x->left->parent = x;
-
-		y->parent = x->parent;
-		if(y->parent==NILL) {
-			root = y;
-		} else if(x == x->parent->left) {
-			y->parent->left = y;
-		} else {
-			y->parent->right = y;
+	void access_splay(node* x,int depth) {
+		switch(policy) {
+			case full:
+				splay(x);
+				break;
+			case semi:
+				engine().semi_splay(x);
+				break;
+			case depth_threshold:
+				if(depth>splay_depth_threshold) splay(x);
+				break;
+			case randomized:
+				if(std::generate_canonical<double,32>(splay_gen)<splay_probability) splay(x);
+				break;
 		}
-
-		y->right = x;
-		x->parent = y;
-
-		x->height = max(x->left->height,x->right->height) + 1;
-		x->size = x->left->size + x->right->size + 1;
-
-		relax_augmentation(x);
-		relax_augmentation(y);
 	}
 
 	/**
-	 * Does a Single splay Rotation
+	 * splays the node where the search for val ends to the root
+	 * regardless of the splay policy
+	 * afterwards the root holds val or one of its neighbours in sorted order
 	 */ 
-	void single_splay(node* x) {
-		if(x->parent->parent==NILL) {
-			if(x==x->parent->left) single_rotate_right(x->parent);
-			else single_rotate_left(x->parent);
-
-		} else {
-			node* grandfather = x->parent->parent;
-			relax_augmentation(x->parent);
-			if(x->parent == grandfather->left) {
-				if(x == x->parent->left) {
-					single_rotate_right(grandfather);
-					single_rotate_right(x->parent);
-				} else {
-					single_rotate_left(x->parent);
-					single_rotate_right(x->parent);
-				}
-			} else {
-				if(x == x->parent->right) {
-					single_rotate_left(grandfather);
-					single_rotate_left(x->parent);
-				} else {
-					single_rotate_right(x->parent);
-					single_rotate_left(x->parent);
-				}
-			}
+	template<class K>
+	void splay_key(const K& val) {
+		node* x = root;
+		node* prev = NILL;
+		while(x!=NILL) {
+			prev = x;
+			if(comp(x->key,val)) x = x->child[1];
+			else if(comp(val,x->key)) x = x->child[0];
+			else break;
 		}
+
+		if(prev!=NILL) splay(prev);
 	}
 
-	void splay(node* x) {
-		while(x->parent!=NILL) {
-			single_splay(x);
+	/**
+	 * rebuilds the filter from the keys without splaying, for when whole
+	 * subtrees moved between trees
+	 */ 
+	void refill_filter() {
+		if(!filter.enabled()) return;
+		filter.clear();
+		node* x = root;
+		if(x!=NILL) {
+			while(x->child[0]!=NILL) x = x->child[0];
 		}
+		for(;x!=NILL;x=successor(x)) filter.add(x->key);
 	}
 
 	/**
-	 * A helper function for the erase(iterator) method
+	 * splays z to the root and takes it out of the tree, without freeing it
 	 * z can't be NILL
 	 */ 
-	void erase(node* z) {
+	void unlink(node* z) {
 		splay(z);
 
-		if(z->left==NILL) transplant(z,z->right);
-		else if(z->right==NILL) transplant(z,z->left);
+		if(z->child[0]==NILL) engine().transplant(z,z->child[1]);
+		else if(z->child[1]==NILL) engine().transplant(z,z->child[0]);
 		else {
-			node* y = predecessor(z); //y is not NILL and y has no left child cause z->left is not NILL
-			root = z->left;
+			node* y = predecessor(z); //y is not NILL and y has no left child cause z->child[0] is not NILL
+			root = z->child[0];
 			root->parent = NILL;
 
 			splay(y);
 
-			y->right = z->right;
-			if(y->right!=NILL) y->right->parent = y;
+			y->child[1] = z->child[1];
+			if(y->child[1]!=NILL) y->child[1]->parent = y;
 
 			relax_augmentation(y);
 		}
+	}
+
+	/**
+	 * A helper function for the erase(iterator) method
+	 * z can't be NILL
+	 */ 
+	void erase(node* z) {
+		filter.remove(z->key);
+		unlink(z);
+		arena.release(z);
+	}
+
+	/**
+	 * hangs z, unlinked and holding its new key, into the tree as a leaf
+	 * and splays it to the root, returns its rank
+	 * there must be no node equivalent to z->key
+	 */ 
+	int link(node* z) {
+		node* y = NILL;
+		node* x = root;
+		while(x!=NILL) {
+			y = x;
+			x = x->child[comp(x->key,z->key)];
+		}
+
+		z->child[0] = z->child[1] = NILL;
+		z->parent = y;
+		z->height = 0;
+		z->size = 1;
+		if(y==NILL) root = z;
+		else y->child[comp(y->key,z->key)] = z;
 
-		delete z;
+		splay(z);
+		return z->child[0]->size;
 	}
 
-	public:
-	iterator find(const T& val) {
+	/**
+	 * returns the node holding a key equivalent to val or NILL
+	 * splays the last visited node according to the splay policy
+	 * K is T or, with a transparent comparator, any type Comp can compare with T
+	 */ 
+	template<class K>
+	node* find_node(const K& val) {
 		node* x = root;
 		node* prev = NILL;
+		int depth = 0;
 		while(x!=NILL) {
 			prev = x;
-			if(comp(x->key,val)) x = x->right;
-			else if(comp(val,x->key)) x = x->left;
+			if(comp(x->key,val)) x = x->child[1];
+			else if(comp(val,x->key)) x = x->child[0];
 			else {
-				splay(x);
-				return iterator(x);
+				access_splay(x,depth);
+				return x;
 			}
+			depth++;
+		}
+
+		if(prev!=NILL) access_splay(prev,depth-1);
+		return NILL;
+	}
 
+	/**
+	 * returns number of nodes smaller than val
+	 * splays the last visited node according to the splay policy
+	 */ 
+	template<class K>
+	int order_of_key_node(const K& val) {
+		node* x = root;
+		node* prev = NILL;
+		int p = 0;
+		int depth = 0;
+		while(x!=NILL) {
+			prev = x;
+			if(comp(x->key,val)) {
+				p += x->child[0]->size+1;
+				x = x->child[1];
+			} else if(comp(val,x->key)) {
+				x=x->child[0];
+			} else {
+				p+=x->child[0]->size;
+				access_splay(x,depth);
+				return p;
+			}
+			depth++;
 		}
 
-		if(prev!=NILL) splay(prev);
-		return iterator(NILL);
+		if(prev!=NILL) access_splay(prev,depth-1);
+		return p;
+	}
+
+	public:
+	/**
+	 * the type of the comparator the keys are ordered by
+	 */
+	typedef Comp key_compare;
+
+	iterator find(const T& val) {
+		if(filter.enabled() && !filter.may_contain(val)) return iterator(NILL);
+		node* x = find_node(val);
+		if(x==NILL && filter.enabled()) filter.false_positive();
+		return iterator(x);
+	}
+
+	/**
+	 * heterogeneous lookup
+	 * only takes part in overload resolution when Comp::is_transparent exists
+	 * e.g. std::less<> lets a tree of std::string be searched with a string_view
+	 * without building a temporary key
+	 */ 
+	template<class K,class C = Comp,class = typename C::is_transparent>
+	iterator find(const K& val) {
+		return iterator(find_node(val));
 	}
 
 
@@ -288,37 +368,172 @@ class splay_tree {
 	 * preserves augmentation properties
 	 * If the value already exists in the tree it does not insert it again 
 	 * but does a splay from the leaf
+	 * Returns an iterator to the element equivalent to val and its rank,
+	 * which is the size of its left subtree once it is splayed to the root
 	 */ 
-	void insert(const T& val) {
+	std::pair<iterator,int> insert(const T& val) {
 		node* y = NILL;
 		node* x = root;
 
 		while(x!=NILL) {
 			y = x;
 
-			if(comp(x->key,val)) x = x->right;
-			else if(comp(val,x->key)) x = x->left;
+			if(comp(x->key,val)) x = x->child[1];
+			else if(comp(val,x->key)) x = x->child[0];
 			else {
 				splay(x);
-				return; //value already in tree
+				return std::make_pair(iterator(x),x->child[0]->size); //value already in tree
 			}
 		}
 
 		node* z = new node(val,NILL,NILL,NILL);
 		z->parent = y;
+		filter.add(val);
 
 		if(y==NILL) root = z;
-		else if(comp(val,y->key)) y->left = z;
-		else y->right = z;
+		else if(comp(val,y->key)) y->child[0] = z;
+		else y->child[1] = z;
 
 
 		splay(z);
+		return std::make_pair(iterator(z),z->child[0]->size);
 	}
 
 	void erase(iterator it) {
 		erase(it.it);
 	}
 
+	/**
+	 * Erases the element equivalent to val
+	 * one descent and one splay, where find + erase(iterator) splays twice
+	 * if there is none the last visited node is splayed and it returns false,
+	 * unless the negative filter rules val out first
+	 */ 
+	bool erase(const T& val) {
+		if(filter.enabled() && !filter.may_contain(val)) return false;
+		node* x = root;
+		node* prev = NILL;
+		while(x!=NILL) {
+			prev = x;
+			if(comp(x->key,val)) x = x->child[1];
+			else if(comp(val,x->key)) x = x->child[0];
+			else {
+				erase(x);
+				return true;
+			}
+		}
+
+		if(prev!=NILL) splay(prev);
+		if(filter.enabled()) filter.false_positive();
+		return false;
+	}
+
+	/**
+	 * Erases the kth smallest element, k is 0 indexed
+	 * the descent does not splay, only the erase does
+	 * returns false if k is out of range
+	 */ 
+	bool erase_by_order(int k) {
+		if(k<0 || k>=(int)root->size) return false;
+		erase(select_node(root,k));
+		return true;
+	}
+
+	/**
+	 * Changes the key of the element at it to new_key and returns its new rank.
+	 * If new_key still falls strictly between the neighbouring elements only
+	 * the key is replaced, otherwise the node is unlinked and hung back in at
+	 * its new place. Either way the node is neither freed nor reallocated,
+	 * it and all other iterators stay valid, and it ends up at the root.
+	 * Returns -1 and changes nothing if another element is equivalent to
+	 * new_key, that check does not splay.
+	 */ 
+	int update_key(iterator it,const T& new_key) {
+		node* z = it.it;
+		node* prev = predecessor(z);
+		node* next = successor(z);
+		if((prev==NILL || comp(prev->key,new_key)) && (next==NILL || comp(new_key,next->key))) {
+			filter.remove(z->key);
+			filter.add(new_key);
+			z->key = new_key;
+			splay(z);
+			return z->child[0]->size;
+		}
+
+		for(node* x=root;x!=NILL;) {
+			if(comp(x->key,new_key)) x = x->child[1];
+			else if(comp(new_key,x->key)) x = x->child[0];
+			else if(x!=z) return -1;
+			else break;
+		}
+
+		filter.remove(z->key);
+		filter.add(new_key);
+		unlink(z);
+		z->key = new_key;
+		return link(z);
+	}
+
+	/**
+	 * Keeps a counting Bloom filter of the keys in budget_bytes of memory,
+	 * updated by every insert and erase, so that find and erase of an
+	 * absent key usually return without a descent and without a splay.
+	 * Roughly 10 bytes per key give a false positive rate around 1%.
+	 * Building it is O(n) and does not splay, budget_bytes = 0 disables it.
+	 * split and join refill the filters of the trees involved in O(n).
+	 */ 
+	void enable_negative_filter(std::size_t budget_bytes,std::function<std::size_t(const T&)> hash = std::hash<T>()) {
+		filter.enable(budget_bytes,hash);
+		refill_filter();
+	}
+
+	/**
+	 * queries, rejections, false positives and memory of the filter
+	 */ 
+	const negative_filter<T>& negative_filter_stats() {
+		return filter;
+	}
+
+	void reset_negative_filter_stats() {
+		filter.reset_stats();
+	}
+
+	/**
+	 * Moves every node into one contiguous block in the order of policy,
+	 * keeping the shape and the augmentation, so the paths splaying keeps
+	 * short also touch few cache lines and pages. O(n) time, a
+	 * van_emde_boas layout takes O(n log height).
+	 * Invalidates iterators.
+	 */ 
+	void relayout(relayout_policy policy = van_emde_boas) {
+		begin_relayout(policy);
+		relayout_step(std::size_t(-1));
+	}
+
+	void compact() {
+		relayout(van_emde_boas);
+	}
+
+	/**
+	 * Incremental relayout: begin_relayout plans the order in one read only
+	 * O(n) traversal, then every relayout_step moves at most max_nodes
+	 * nodes and returns true once the pass is complete.
+	 * The tree can be used and modified in between, nodes inserted
+	 * meanwhile stay outside the block until the next pass.
+	 * Every step invalidates iterators. split and join abandon the pass.
+	 */ 
+	void begin_relayout(relayout_policy policy = van_emde_boas) {
+		arena.begin(root,NILL,policy);
+	}
+
+	bool relayout_step(std::size_t max_nodes) {
+		return arena.step(root,NILL,max_nodes);
+	}
+
+	bool relayout_pending() {
+		return arena.pending();
+	}
+
 	bool empty() {
 		return !(root->size);
 	}
@@ -326,14 +541,40 @@ class splay_tree {
 		return root->size;
 	}
 
+	/**
+	 * Bytes used by the nodes, the allocator and the negative filter,
+	 * see tree_stats.hpp. The approximate mode is O(1) in the number of
+	 * nodes, the exact mode walks them. Neither splays.
+	 */ 
+	tree_memory_usage memory_usage(stats_mode mode = stats_approximate) {
+		std::size_t auxiliary = sizeof(*this)+filter.memory_usage()+arena.scratch_bytes();
+		return measure_memory(root,NILL,root->size,arena.block_nodes(),arena.block_bytes(),auxiliary,mode,
+			[this](node* x) {return arena.in_block(x);});
+	}
+
+	/**
+	 * Depth histogram, average and max depth and rotations, see tree_stats.hpp.
+	 * The approximate mode samples O(log n) descents (O(n) each in the worst
+	 * case of a splay tree), the max depth is exact in both modes (the height
+	 * of the root). Neither splays.
+	 */ 
+	tree_shape_stats shape_stats(stats_mode mode = stats_approximate) {
+		tree_shape_stats s = measure_shape(root,NILL,root->size,mode,[](node*) {return 1;});
+		s.max_depth = root->height;
+		s.rotations = rotation_count;
+		return s;
+	}
+
 	iterator begin() {
 		node* x = root;
+		int depth = 0;
 		if(x!=NILL) {
-			while(x->left!=NILL) {
-				x=x->left;
+			while(x->child[0]!=NILL) {
+				x=x->child[0];
+				depth++;
 			}
 		}
-		if(x!=NILL) splay(x);
+		if(x!=NILL) access_splay(x,depth);
 		return iterator(x);
 	}
 
@@ -355,20 +596,22 @@ class splay_tree {
 		k++;
 		node* x = root;
 		node* y = NILL;
+		int depth = 0;
 		while(x!=NILL) {
 			y = x;
-			if(x->left->size>=k) x = x->left;
-			else if(x->left->size+1==k) {
-				splay(x);
+			if(x->child[0]->size>=k) x = x->child[0];
+			else if(x->child[0]->size+1==k) {
+				access_splay(x,depth);
 				return iterator(x);
 			}
 			else {
-				k-=(x->left->size+1);
-				x = x->right;
+				k-=(x->child[0]->size+1);
+				x = x->child[1];
 			}
+			depth++;
 		}
 
-		if(y!=NILL) splay(y);
+		if(y!=NILL) access_splay(y,depth-1);
 		return iterator(x);
 	}
 
@@ -377,25 +620,110 @@ class splay_tree {
 	 * 
 	 */
 	int order_of_key(const T& val) {
-		node* x = root;
-		node* prev = NILL;
-		int p = 0;
-		while(x!=NILL) {
-			prev = x;
-			if(x->key==val) {
-				p+=x->left->size;
-				splay(x);
-				return p;
-			} else if(x->key>val) {
-				x=x->left;
-			} else {
-				p += x->left->size+1;
-				x = x->right;
-			}
-		}
+		return order_of_key_node(val);
+	}
 
-		if(prev!=NILL) splay(prev);
-		return p;
+	template<class K,class C = Comp,class = typename C::is_transparent>
+	int order_of_key(const K& val) {
+		return order_of_key_node(val);
+	}
+
+	/**
+	 * out[i] = the key of rank ranks[i], for every i, in one shared traversal
+	 * O(k log(n/k)) for k ranks instead of k separate descents
+	 * the tree is not splayed
+	 * ranks must be sorted and 0 <= ranks[i] < size()
+	 */ 
+	void select_many(const std::vector<int>& ranks,std::vector<T>& out) {
+		out.resize(ranks.size());
+		select_many_nodes(root,NILL,ranks,[](node*) {return 1;},[&out](int i,node* x) {
+			out[i] = x->key;
+		});
+	}
+
+	/**
+	 * out[i] = order_of_key(keys[i]), for every i, in one shared traversal
+	 * the tree is not splayed
+	 * keys must be sorted by Comp
+	 */ 
+	void rank_many(const std::vector<T>& keys,std::vector<int>& out) {
+		out.resize(keys.size());
+		rank_many_nodes(root,NILL,keys,[this](node* x,const T& key) {return comp(x->key,key);},
+			[](node*) {return 1;},[&out](int i,int rank) {out[i] = rank;});
+	}
+
+	/**
+	 * Selects how read operations restructure the tree
+	 * insert, erase, split and join always splay fully
+	 */ 
+	void set_splay_policy(splay_policy p) {
+		policy = p;
+	}
+
+	splay_policy get_splay_policy() {
+		return policy;
+	}
+
+	/**
+	 * For the depth_threshold policy: accesses at depth <= d do not splay
+	 */ 
+	void set_splay_depth_threshold(int d) {
+		splay_depth_threshold = d;
+	}
+
+	/**
+	 * For the randomized policy: each access splays with probability p
+	 */ 
+	void set_splay_probability(double p, unsigned seed = std::minstd_rand::default_seed) {
+		splay_probability = p;
+		splay_gen.seed(seed);
+	}
+
+	/**
+	 * Number of single rotations performed since the tree was created
+	 */ 
+	unsigned long long rotations() {
+		return rotation_count;
+	}
+
+	/**
+	 * calls f(key) on every key, the keys are split into rank ranges of
+	 * equal length that are processed in parallel, in order within a range
+	 * the tree is not splayed
+	 * f must be safe to call concurrently
+	 * the tree must not be modified until it returns
+	 * num_threads = 0 uses std::thread::hardware_concurrency()
+	 */ 
+	template<class F>
+	void parallel_for_each(F f,unsigned num_threads = 0) {
+		unsigned chunks = parallel_rank_chunks(root->size,num_threads);
+		parallel_rank_ranges(root,chunks,[this](int k) {return select_node(root,k);},[&f](unsigned,node* x,int count) {
+			for(int i=0;i<count;i++,x=successor(x)) f(x->key);
+		});
+	}
+
+	/**
+	 * returns init op k0 op k1 op ... op kn-1 over the keys in sorted order
+	 * every rank range is folded on its own thread, then the partial results
+	 * are combined in rank order, so the result is deterministic for an
+	 * associative op (op does not need to be commutative)
+	 * op takes two R, T must be convertible to R
+	 */ 
+	template<class R,class Op>
+	R parallel_reduce(R init,Op op,unsigned num_threads = 0) {
+		if(root->size==0) return init;
+
+		unsigned chunks = parallel_rank_chunks(root->size,num_threads);
+		std::vector<R> partial(chunks,init);
+		parallel_rank_ranges(root,chunks,[this](int k) {return select_node(root,k);},[&](unsigned c,node* x,int count) {
+			R acc = x->key;
+			x = successor(x);
+			for(int i=1;i<count;i++,x=successor(x)) acc = op(acc,x->key);
+			partial[c] = acc;
+		});
+
+		for(unsigned c=0;c<chunks;c++) init = op(init,partial[c]);
+		return init;
 	}
 
 	~splay_tree() {
@@ -403,7 +731,7 @@ class splay_tree {
 	}
 
 	static void split(splay_tree<T,Comp>& t,splay_tree<T,Comp>& s1,splay_tree<T,Comp>& s2,const T& val) {
-		bool flag = (t.find(val)!=t.end());
+		t.splay_key(val);
 
 		s1.erase_sub_tree(s1.root);
 		s2.erase_sub_tree(s2.root);
@@ -414,22 +742,31 @@ class splay_tree {
 		if(t.root!=NILL) { 
 			if(!t.comp(val,t.root->key)) {
 				s1.root = t.root;
-				s2.root = t.root->right;
+				s2.root = t.root->child[1];
 
-				s1.root->right=NILL;
+				s1.root->child[1]=NILL;
 				s2.root->parent=NILL;
 			} else {
 				s2.root = t.root;
-				s1.root = t.root->left;
+				s1.root = t.root->child[0];
 
-				s2.root->left = NILL;
+				s2.root->child[0] = NILL;
 				s1.root->parent = NILL;
 			}
 		}
 
-		relax_augmentation(s1.root);
-		relax_augmentation(s2.root);
+		if(s1.root!=NILL) s1.relax_augmentation(s1.root);
+		if(s2.root!=NILL) s2.relax_augmentation(s2.root);
 		t.root = NILL;
+
+		// nodes in t's relayout blocks now belong to s1 and s2
+		s1.arena.share(t.arena);
+		s2.arena.share(t.arena);
+		t.arena.clear();
+
+		t.refill_filter();
+		s1.refill_filter();
+		s2.refill_filter();
 	} 
 
 	static void join(splay_tree<T,Comp>& t,splay_tree<T,Comp>& s1,splay_tree<T,Comp>& s2) {
@@ -443,14 +780,26 @@ class splay_tree {
 			t.root = s1.root;
 			s1.root = NILL;
 		} else {
-			s1.find_by_order(s1.size()-1);       
-			s1.root->right = s2.root;
+			node* x = s1.root;
+			while(x->child[1]!=NILL) x = x->child[1];
+			s1.splay(x);
+
+			s1.root->child[1] = s2.root;
 			s2.root->parent = s1.root;
 			s2.root = NILL;
 			t.root = s1.root;
-			relax_augmentation(t.root);
+			t.relax_augmentation(t.root);
 			s1.root = NILL;
 		}
+
+		t.arena.share(s1.arena);
+		t.arena.share(s2.arena);
+		s1.arena.clear();
+		s2.arena.clear();
+
+		t.refill_filter();
+		s1.refill_filter();
+		s2.refill_filter();
 	}
 
 
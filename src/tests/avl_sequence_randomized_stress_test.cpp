@@ -0,0 +1,5 @@
+#include "../avl_sequence.hpp"
+
+AVLSequence<int> seq, rest;
+
+#include "sequence_randomized_stress_test.cpp"
\ No newline at end of file
@@ -0,0 +1,6 @@
+#include "../avl_tree.hpp"
+#include "relayouting_tree.cpp"
+
+relayouting_tree<AVLTree<int>> bst;
+
+#include "randomized_stress_test.cpp"
@@ -0,0 +1,24 @@
+#include <set>
+#include <utility>
+
+/**
+ * std::set based reference implementation of the dominance counter interface
+ * every count scans all points
+ */
+struct brute_force_dominance {
+	std::set<std::pair<int,int>> s;
+
+	void insert(int x, int y) {s.insert(std::make_pair(x, y));}
+	bool erase(int x, int y) {return s.erase(std::make_pair(x, y)) > 0;}
+	unsigned size() {return s.size();}
+
+	int count(int X, int Y) {
+		int c = 0;
+		for(const std::pair<int,int>& p : s) c += (p.first <= X && p.second <= Y);
+		return c;
+	}
+};
+
+brute_force_dominance points;
+
+#include "dominance_randomized_stress_test.cpp"
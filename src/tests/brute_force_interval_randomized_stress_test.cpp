@@ -0,0 +1,42 @@
+#include <set>
+#include <utility>
+
+/**
+ * std::set based reference implementation of the interval tree interface
+ * every query scans all intervals
+ */
+template<class T>
+struct brute_force_intervals {
+	typedef typename std::set<std::pair<T,T>>::iterator iterator;
+	std::set<std::pair<T,T>> s;
+
+	void insert(const T& lo, const T& hi) {s.insert(std::make_pair(lo, hi));}
+	iterator find(const T& lo, const T& hi) {return s.find(std::make_pair(lo, hi));}
+	void erase(iterator it) {s.erase(it);}
+	iterator end() {return s.end();}
+	unsigned size() {return s.size();}
+
+	int count_overlapping(const T& lo, const T& hi) {
+		int c = 0;
+		for(const std::pair<T,T>& p : s) c += (p.first <= hi && lo <= p.second);
+		return c;
+	}
+
+	iterator find_overlapping(const T& point) {
+		for(iterator it = s.begin(); it != s.end(); ++it) {
+			if(it->first <= point && point <= it->second) return it;
+		}
+		return s.end();
+	}
+
+	template<class F>
+	void for_each_overlapping(const T& lo, const T& hi, F f) {
+		for(const std::pair<T,T>& p : s) {
+			if(p.first <= hi && lo <= p.second) f(p);
+		}
+	}
+};
+
+brute_force_intervals<int> intervals;
+
+#include "interval_randomized_stress_test.cpp"
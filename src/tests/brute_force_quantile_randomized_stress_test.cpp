@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+/**
+ * reference implementation of the sliding_quantile_streams interface
+ * one entry per event, every query sorts the window
+ */
+struct brute_force_window {
+	std::deque<std::pair<int,long long>> events;
+	int max_events;
+	long long max_age;
+
+	brute_force_window(int max_events, long long max_age) : max_events(max_events), max_age(max_age) {}
+
+	void expire(long long now) {
+		while(!events.empty() && events.front().second <= now - max_age) events.pop_front();
+	}
+
+	void push(int val, long long time, int count) {
+		for(int i = 0; i < count; i++) events.push_back(std::make_pair(val, time));
+		expire(time);
+		while((int)events.size() > max_events) events.pop_front();
+	}
+
+	std::vector<int> sorted() {
+		std::vector<int> v;
+		for(const std::pair<int,long long>& e : events) v.push_back(e.first);
+		std::sort(v.begin(), v.end());
+		return v;
+	}
+
+	int order_of_key(int val) {
+		std::vector<int> v = sorted();
+		return std::lower_bound(v.begin(), v.end(), val) - v.begin();
+	}
+
+	int size() {return events.size();}
+	bool empty() {return events.empty();}
+};
+
+struct brute_force_streams {
+	std::deque<brute_force_window> windows;
+
+	brute_force_window& stream(unsigned id) {
+		while(windows.size() <= id) windows.emplace_back(64, 1500);
+		return windows[id];
+	}
+
+	void push(unsigned id, int val, long long time, int count) {stream(id).push(val, time, count);}
+
+	int quantile(unsigned id, double q) {
+		// nearest rank, the smallest value with at least q * n values up to it
+		std::vector<int> v = stream(id).sorted();
+		for(std::size_t i = 0; i + 1 < v.size(); i++) {
+			if(i + 1 >= q * v.size() - 1e-9) return v[i];
+		}
+		return v.back();
+	}
+
+	void expire(long long now) {
+		for(brute_force_window& w : windows) w.expire(now);
+	}
+};
+
+brute_force_streams streams;
+
+#include "quantile_randomized_stress_test.cpp"
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "../tree_stats.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * Trees with their optional modes switched on in the constructor, so the
+ * differential harness runs them like any other tree. Checks that the
+ * results can't show abort with a message.
+ */
+
+[[noreturn]] void configured_tree_failure(const char* name, const char* what) {
+	std::fprintf(stderr, "%s: %s\n", name, what);
+	std::abort();
+}
+
+/**
+ * splay_tree whose read operations restructure according to Policy,
+ * shallow accesses (depth <= 8) do not splay with depth_threshold and a
+ * quarter of the accesses splay with randomized
+ */
+template<class Tree, int Policy>
+struct splay_policy_tree : Tree {
+	splay_policy_tree() {
+		Tree::set_splay_policy((typename Tree::splay_policy)Policy);
+		Tree::set_splay_depth_threshold(8);
+		Tree::set_splay_probability(0.25);
+	}
+};
+
+/**
+ * AVLTree or RBTree in lazy erase mode with a low tombstone threshold, so
+ * erases mostly leave tombstones and the tree is rebuilt every few hundred
+ * erases. Every other erase inserts the key again, which revives its
+ * tombstone and must return the right rank, and erases it once more.
+ * Every REBUILD_EVERY inserts it also rebuilds right after the insert, the
+ * returned iterator must still point at the inserted key, and the depth
+ * must fit the red-black bound of the rebuilt tree's black height (RBTree).
+ */
+template<class Tree>
+struct lazy_erase_tree : Tree {
+	static const int REBUILD_EVERY = 5000;
+	int inserts = 0;
+	int erases = 0;
+
+	void revive(int key) {
+		if(++erases % 2) return;
+		if(Tree::insert(key).second != Tree::order_of_key(key)) configured_tree_failure("lazy erase", "rank of a revived key");
+		Tree::erase(key);
+	}
+
+	lazy_erase_tree() {
+		Tree::set_lazy_erase(true, 0.05);
+	}
+
+	decltype(auto) insert(int val) {
+		auto r = Tree::insert(val);
+		if(++inserts % REBUILD_EVERY == 0) {
+			Tree::rebuild();
+			if(Tree::tombstones() != 0) configured_tree_failure("lazy erase", "tombstones left by rebuild");
+			if(*r.first != val || Tree::find(val) != r.first) configured_tree_failure("lazy erase", "iterator moved by rebuild");
+
+			tree_shape_stats shape = Tree::shape_stats(stats_exact);
+			if(shape.black_height != -1 && (shape.black_height == 0 || shape.max_depth + 1 > 2 * shape.black_height)) {
+				configured_tree_failure("lazy erase", "rebuilt tree is not red-black");
+			}
+		}
+		return r;
+	}
+
+	bool erase(int val) {
+		bool erased = Tree::erase(val);
+		if(erased) revive(val);
+		return erased;
+	}
+
+	template<class Iterator>
+	void erase(const Iterator& it) {
+		int key = *it;
+		Tree::erase(it);
+		revive(key);
+	}
+
+	bool erase_by_order(int k) {
+		if(k < 0 || k >= (int)Tree::size()) return false;
+		int key = *Tree::find_by_order(k);
+		Tree::erase_by_order(k);
+		revive(key);
+		return true;
+	}
+};
+
+/**
+ * erases val, which it points at, after moving it with update_key to the
+ * next key, usually in place, or to a far key when that one is free
+ */
+template<class Tree, class Iterator>
+void erase_moved(Tree& bst, const Iterator& it, int val) {
+	int moved = val % 4 ? val + 1 : ~val;
+	if(bst.update_key(it, moved) >= 0) val = moved;
+	bst.erase(val);
+}
+
+/**
+ * AVLTree or RBTree with a lookup cache. After every update it looks up
+ * two of the last RECENT keys it saw, which are likely cached from before
+ * the update, with find and order_of_key and checks both answers through
+ * find_by_order, which bypasses the cache. Every other successful erase
+ * by key first moves the key with update_key, in place or to a far key,
+ * and erases it there.
+ */
+template<class Tree>
+struct cached_tree : Tree {
+	static const int RECENT = 16;
+	int recent[RECENT] = {};
+	unsigned seen = 0;
+	int erases = 0;
+
+	cached_tree() {
+		Tree::enable_lookup_cache(64);
+	}
+
+	void saw(int key) {
+		recent[seen++ % RECENT] = key;
+	}
+
+	/**
+	 * order_of_key and find of key agree with the keys around its rank
+	 */
+	void check(int key) {
+		int rank = Tree::order_of_key(key);
+		int size = Tree::size();
+		if(rank < 0 || rank > size || (rank > 0 && *Tree::find_by_order(rank - 1) >= key)
+			|| (rank < size && *Tree::find_by_order(rank) < key)) {
+			configured_tree_failure("lookup cache", "stale rank");
+		}
+
+		auto it = Tree::find(key);
+		bool present = rank < size && *Tree::find_by_order(rank) == key;
+		if((it != Tree::end()) != present || (present && *it != key)) configured_tree_failure("lookup cache", "stale node");
+	}
+
+	void updated() {
+		check(recent[seen % RECENT]);
+		check(recent[(seen * 7 + 3) % RECENT]);
+	}
+
+	decltype(auto) insert(int val) {
+		saw(val);
+		auto r = Tree::insert(val);
+		updated();
+		return r;
+	}
+
+	bool erase(int val) {
+		saw(val);
+		auto it = Tree::find(val);
+		if(it == Tree::end()) {
+			updated();
+			return false;
+		}
+
+		if(++erases % 2) Tree::erase(val);
+		else erase_moved<Tree>(*this, it, val);
+		updated();
+		return true;
+	}
+
+	template<class Iterator>
+	void erase(const Iterator& it) {
+		saw(*it);
+		Tree::erase(it);
+		updated();
+	}
+
+	bool erase_by_order(int k) {
+		bool erased = Tree::erase_by_order(k);
+		updated();
+		return erased;
+	}
+
+	int order_of_key(int val) {
+		saw(val);
+		return Tree::order_of_key(val);
+	}
+
+	decltype(auto) find(int val) {
+		saw(val);
+		return Tree::find(val);
+	}
+};
+
+/**
+ * Tree with a negative filter small enough to have false positives. After
+ * every update it finds a present key, picked by rank, which the filter
+ * must not turn away. Every other successful erase by key first moves the
+ * key with update_key, like cached_tree.
+ */
+template<class Tree>
+struct filtered_tree : Tree {
+	static const int BUDGET_BYTES = 1 << 16;
+	unsigned updates = 0;
+	int erases = 0;
+
+	filtered_tree() {
+		Tree::enable_negative_filter(BUDGET_BYTES);
+	}
+
+	void updated() {
+		int size = Tree::size();
+		if(size == 0) return;
+		int key = *Tree::find_by_order(++updates * 2654435761u % size);
+		if(Tree::find(key) == Tree::end()) configured_tree_failure("negative filter", "present key rejected");
+	}
+
+	decltype(auto) insert(int val) {
+		auto r = Tree::insert(val);
+		updated();
+		return r;
+	}
+
+	bool erase(int val) {
+		auto it = Tree::find(val);
+		if(it == Tree::end()) return false;
+		if(++erases % 2) Tree::erase(val);
+		else erase_moved<Tree>(*this, it, val);
+		updated();
+		return true;
+	}
+
+	template<class Iterator>
+	void erase(const Iterator& it) {
+		Tree::erase(it);
+		updated();
+	}
+
+	bool erase_by_order(int k) {
+		bool erased = Tree::erase_by_order(k);
+		updated();
+		return erased;
+	}
+};
+
+/**
+ * splay_tree that every SPLIT_EVERY updates splits itself at a present key
+ * into two trees with filters, finds every key of both halves through
+ * their refilled filters and joins them back
+ */
+template<class Tree>
+struct splitting_tree : Tree {
+	static const int SPLIT_EVERY = 20000;
+	static const int BUDGET_BYTES = 1 << 16;
+	int updates = 0;
+
+	static void check_keys(Tree& half) {
+		std::vector<int> keys;
+		for(auto it = half.begin(); it != half.end(); ++it) keys.push_back(*it);
+		for(int key : keys) {
+			if(half.find(key) == half.end()) configured_tree_failure("negative filter", "key rejected after split");
+		}
+	}
+
+	void updated() {
+		if(++updates % SPLIT_EVERY != 0 || Tree::size() == 0) return;
+		int key = *Tree::find_by_order(updates / SPLIT_EVERY % Tree::size());
+		unsigned size = Tree::size();
+
+		Tree s1, s2;
+		s1.enable_negative_filter(BUDGET_BYTES);
+		s2.enable_negative_filter(BUDGET_BYTES);
+		Tree::split(*this, s1, s2, key);
+		if(s1.size() + s2.size() != size || s1.find(key) == s1.end()) configured_tree_failure("split", "halves do not add up");
+		check_keys(s1);
+		check_keys(s2);
+		Tree::join(*this, s1, s2);
+		if(Tree::size() != size || Tree::find(key) == Tree::end()) configured_tree_failure("join", "keys lost");
+	}
+
+	decltype(auto) insert(int val) {
+		auto r = Tree::insert(val);
+		updated();
+		return r;
+	}
+
+	template<class A>
+	decltype(auto) erase(const A& a) {
+		struct after {
+			splitting_tree* t;
+			~after() {t->updated();}
+		} s{this};
+		return Tree::erase(a);
+	}
+
+	bool erase_by_order(int k) {
+		bool erased = Tree::erase_by_order(k);
+		updated();
+		return erased;
+	}
+};
@@ -0,0 +1,197 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+#include "../wb_tree.hpp"
+#include "configured_trees.cpp"
+#include "ost_reference.cpp"
+#include "relayouting_tree.cpp"
+#include "stress_operations.cpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * The randomized stress test of every tree against the __gnu_pbds
+ * reference in one process, without printing the results.
+ *
+ * The operations are split into shards with seeds seed, seed+1, ...
+ * Every run folds its results into a rolling hash and keeps the hash at
+ * the end of each window of CHECK_EVERY operations, so a mismatch is
+ * narrowed down to a window that the text driver (randomized_stress_test.cpp,
+ * the same operations for the same seed) can then print in full.
+ *
+ * The reference shards run in parallel. The tree classes keep their NILL
+ * sentinel in a static member that some of them write during updates
+ * (RBTree sets NILL->parent when erasing), so all runs of one tree class,
+ * wrapped or not, form a lane that runs on a single thread, and the
+ * lanes run in parallel. Every tree is timed on its own, the ops/s are
+ * those of the tree, and with a time limit the test fails when the
+ * shards of a tree take longer than that in total.
+ */
+
+using namespace std;
+
+const int CHECK_EVERY = 4096;
+
+template<class V, class = typename enable_if<is_integral<V>::value>::type>
+unsigned long long hash_result(V v) {
+	return (unsigned long long)v * 0x9E3779B97F4A7C15ULL;
+}
+
+unsigned long long hash_result(const char*) {
+	return 0x6E6F6E65ULL; // "None"
+}
+
+struct checkpoints {
+	vector<unsigned long long> hashes; // hash after each window of CHECK_EVERY operations
+	unsigned long long h = 0;
+
+	void add(int i, unsigned long long v) {
+		while((long long)(hashes.size() + 1) * CHECK_EVERY <= i) hashes.push_back(h);
+		h = (h ^ v) * 0x100000001B3ULL + 1;
+	}
+
+	void finish(int num_iterations) {
+		while((long long)hashes.size() * CHECK_EVERY < num_iterations) hashes.push_back(h);
+	}
+};
+
+template<class Tree>
+checkpoints run_hashed(int seed, int num_iterations) {
+	Tree bst;
+	checkpoints cp;
+	run_operations(bst, seed, num_iterations, [&cp](int i, const auto& result) {
+		cp.add(i, hash_result(result));
+	});
+	cp.finish(num_iterations);
+	return cp;
+}
+
+struct tree_under_test {
+	const char* name;
+	function<checkpoints(int, int)> run;
+	double seconds = 0;
+	long long ops = 0;
+	string failure;
+};
+
+template<class Tree>
+tree_under_test tree(const char* name) {
+	tree_under_test t;
+	t.name = name;
+	t.run = run_hashed<Tree>;
+	return t;
+}
+
+/**
+ * calls f(0), ..., f(count-1) on up to num_threads threads
+ */
+template<class F>
+void parallel_tasks(int count, unsigned num_threads, F f) {
+	atomic<int> next(0);
+	auto worker = [&]() {
+		for(int i; (i = next++) < count;) f(i);
+	};
+
+	vector<thread> threads;
+	for(unsigned t = 1; t < num_threads && (int)t < count; t++) threads.emplace_back(worker);
+	worker();
+	for(thread& t : threads) t.join();
+}
+
+double seconds_since(chrono::steady_clock::time_point begin) {
+	return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations> [num_shards] [time_limit_seconds] [num_threads]\n";
+		return 1;
+	}
+
+	int seed = atoi(argv[1]);
+	int num_iterations = atoi(argv[2]);
+	int num_shards = argc > 3 ? atoi(argv[3]) : 16;
+	double time_limit = argc > 4 ? atof(argv[4]) : 0;
+	unsigned num_threads = argc > 5 ? atoi(argv[5]) : thread::hardware_concurrency();
+	if(num_threads == 0) num_threads = 1;
+
+	// shard s runs seed + s, num_iterations are spread evenly
+	vector<int> shard_ops(num_shards);
+	for(int s = 0; s < num_shards; s++) shard_ops[s] = num_iterations / num_shards + (s < num_iterations % num_shards);
+
+	tree_under_test reference = tree<ost_reference>("gnu_ost (reference)");
+	vector<checkpoints> expected(num_shards);
+	vector<double> reference_seconds(num_shards);
+	parallel_tasks(num_shards, num_threads, [&](int s) {
+		auto begin = chrono::steady_clock::now();
+		expected[s] = reference.run(seed + s, shard_ops[s]);
+		reference_seconds[s] = seconds_since(begin);
+	});
+	for(int s = 0; s < num_shards; s++) {
+		reference.seconds += reference_seconds[s];
+		reference.ops += shard_ops[s];
+	}
+
+	vector<vector<tree_under_test>> lanes = {
+		{tree<AVLTree<int>>("avl"), tree<relayouting_tree<AVLTree<int>>>("avl relayout"),
+			tree<lazy_erase_tree<AVLTree<int>>>("avl lazy erase"),
+			tree<relayouting_tree<cached_tree<AVLTree<int>>>>("avl cache relayout"),
+			tree<filtered_tree<lazy_erase_tree<AVLTree<int>>>>("avl filter lazy")},
+		{tree<RBTree<int>>("rb"), tree<relayouting_tree<RBTree<int>>>("rb relayout"),
+			tree<lazy_erase_tree<RBTree<int>>>("rb lazy erase"),
+			tree<relayouting_tree<cached_tree<lazy_erase_tree<RBTree<int>>>>>("rb cache lazy relayout"),
+			tree<filtered_tree<RBTree<int>>>("rb filter")},
+		{tree<splay_tree<int>>("splay"), tree<relayouting_tree<splay_tree<int>>>("splay relayout"),
+			tree<splay_policy_tree<splay_tree<int>, splay_tree<int>::semi>>("splay semi"),
+			tree<splay_policy_tree<splay_tree<int>, splay_tree<int>::depth_threshold>>("splay depth"),
+			tree<splay_policy_tree<splay_tree<int>, splay_tree<int>::randomized>>("splay randomized"),
+			tree<splitting_tree<filtered_tree<splay_tree<int>>>>("splay filter split")},
+		{tree<WBTree<int>>("wb")},
+	};
+
+	parallel_tasks(lanes.size(), num_threads, [&](int l) {
+		for(tree_under_test& t : lanes[l]) {
+			for(int s = 0; s < num_shards && t.failure.empty(); s++) {
+				auto begin = chrono::steady_clock::now();
+				checkpoints got = t.run(seed + s, shard_ops[s]);
+				t.seconds += seconds_since(begin);
+				t.ops += shard_ops[s];
+
+				for(size_t w = 0; w < got.hashes.size(); w++) {
+					if(got.hashes[w] == expected[s].hashes[w]) continue;
+					t.failure = "seed " + to_string(seed + s) + " differs from the reference in operations ["
+						+ to_string(w * CHECK_EVERY) + ", " + to_string(min<long long>((w + 1) * CHECK_EVERY, shard_ops[s])) + ")";
+					break;
+				}
+			}
+		}
+	});
+
+	bool ok = true;
+	printf("%-24s %12s %9s %12s\n", "tree", "operations", "seconds", "ops/s");
+	printf("%-24s %12lld %9.2f %12.0f\n", reference.name, reference.ops, reference.seconds, reference.ops / reference.seconds);
+	for(vector<tree_under_test>& lane : lanes) {
+		for(tree_under_test& t : lane) {
+			printf("%-24s %12lld %9.2f %12.0f", t.name, t.ops, t.seconds, t.ops / t.seconds);
+			if(!t.failure.empty()) {
+				printf("   FAILED: %s", t.failure.c_str());
+				ok = false;
+			} else if(time_limit > 0 && t.seconds > time_limit) {
+				printf("   FAILED: over the time limit of %.1f s", time_limit);
+				ok = false;
+			}
+			printf("\n");
+		}
+	}
+
+	if(ok) printf("OK\n");
+	return ok ? 0 : 1;
+}
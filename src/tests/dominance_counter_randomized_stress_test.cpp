@@ -0,0 +1,5 @@
+#include "../dominance_counter.hpp"
+
+DominanceCounter<> points(1000);
+
+#include "dominance_randomized_stress_test.cpp"
\ No newline at end of file
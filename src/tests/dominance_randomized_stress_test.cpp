@@ -0,0 +1,48 @@
+#include <random>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]);
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> op_dist(1, 5);
+	std::uniform_int_distribution<int> x_dist(0, 1000);
+	std::uniform_int_distribution<int> y_dist(-1000, 1000);
+
+	for (int i = 0; i < num_iterations; ++i) {
+		int operation = op_dist(gen);
+		int x = x_dist(gen);
+		int y = y_dist(gen);
+
+		switch (operation) {
+			case 1:
+			case 2: {
+					// Insert a random point
+					points.insert(x, y);
+					break;
+				} case 3: {
+					// Erase a random point
+					cout << points.erase(x, y) << endl;
+					break;
+				} case 4: {
+					// Print size
+					cout << points.size() << endl;
+					break;
+				} case 5: {
+					// Count points dominated by a random point, x may fall out of range
+					cout << points.count(x - 10, y) << endl;
+					break;
+				}
+		}
+	}
+
+	return 0;
+}
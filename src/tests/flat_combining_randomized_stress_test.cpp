@@ -0,0 +1,119 @@
+#include "../flat_combining_tree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * flat_combining_tree used by many threads at once, checked in rounds
+ * - update phase: every thread inserts, erases and finds keys of its own
+ *   residue class (key % num_threads), so its results are deterministic
+ *   and are checked against its own std::set, ranks only against bounds
+ * - query phase: the threads only ask order_of_key and find_by_order,
+ *   checked against all the sets merged
+ * prints the first mismatch
+ */
+
+const int KEYS = 1 << 16;
+const int UPDATES_PER_ROUND = 2000;
+const int QUERIES_PER_ROUND = 500;
+
+template<class F>
+string run_threads(int num_threads, F f) {
+	vector<string> errors(num_threads);
+	vector<thread> threads;
+	for(int t = 0; t < num_threads; t++) threads.emplace_back([&, t]() {errors[t] = f(t);});
+	for(thread& t : threads) t.join();
+	for(const string& e : errors) if(!e.empty()) return e;
+	return "";
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations> [num_threads]\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]);
+	int num_threads = argc > 3 ? std::atoi(argv[3]) : 8;
+	int rounds = max(1, num_iterations / (num_threads * (UPDATES_PER_ROUND + QUERIES_PER_ROUND)));
+
+	flat_combining_tree<int> bst(num_threads / 2 + 1); // fewer slots than threads, some wait for one
+	vector<set<int>> own(num_threads);
+	vector<mt19937> gens;
+	for(int t = 0; t < num_threads; t++) gens.emplace_back(seed * 1000 + t);
+
+	for(int round = 0; round < rounds; round++) {
+		string error = run_threads(num_threads, [&](int t) -> string {
+			mt19937& gen = gens[t];
+			set<int>& mine = own[t];
+			for(int i = 0; i < UPDATES_PER_ROUND; i++) {
+				int key = (int)(gen() % (KEYS / num_threads)) * num_threads + t;
+				bool ok = true;
+				switch(gen() % 5) {
+					case 0: case 1: {
+						pair<bool, int> r = bst.insert(key);
+						ok = r.first == mine.insert(key).second && r.second >= 0 && r.second < KEYS;
+						break;
+					}
+					case 2:
+						ok = bst.erase(key) == (mine.erase(key) == 1);
+						break;
+					case 3:
+						ok = bst.contains(key) == (mine.count(key) == 1);
+						break;
+					case 4: {
+						int rank = bst.order_of_key(key);
+						int out = -1;
+						bool found = bst.find_by_order(gen() % KEYS, out);
+						ok = rank >= 0 && rank < KEYS && (!found || (out >= 0 && out < KEYS));
+						break;
+					}
+				}
+				if(!ok) return "thread " + to_string(t) + ": update mismatch in round " + to_string(round);
+			}
+			return "";
+		});
+
+		set<int> all;
+		for(const set<int>& mine : own) all.insert(mine.begin(), mine.end());
+		vector<int> sorted(all.begin(), all.end());
+		if(error.empty() && bst.size() != sorted.size()) error = "size mismatch in round " + to_string(round);
+
+		if(error.empty()) error = run_threads(num_threads, [&](int t) -> string {
+			mt19937& gen = gens[t];
+			for(int i = 0; i < QUERIES_PER_ROUND; i++) {
+				int key = gen() % KEYS;
+				int k = gen() % (sorted.size() + 1);
+				int out = -1;
+				bool found = bst.find_by_order(k, out);
+				int rank = lower_bound(sorted.begin(), sorted.end(), key) - sorted.begin();
+				if(bst.order_of_key(key) != rank || found != (k < (int)sorted.size()) || (found && out != sorted[k])) {
+					return "thread " + to_string(t) + ": query mismatch in round " + to_string(round);
+				}
+			}
+			return "";
+		});
+
+		if(!error.empty()) {
+			cout << error << endl;
+			return 1;
+		}
+	}
+
+	if(bst.combined_requests() == 0 || bst.combined_requests() < bst.batches()) {
+		cout << "batch counts" << endl;
+		return 1;
+	}
+
+	cout << "OK" << endl;
+	return 0;
+}
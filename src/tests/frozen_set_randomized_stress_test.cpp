@@ -0,0 +1,67 @@
+#include "../frozen_set.hpp"
+
+#include <algorithm>
+#include <random>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/**
+ * compile time checks, this file does not build if FrozenSet stops being constexpr
+ */
+constexpr auto codes = make_frozen_set({404, 200, 500, 301, 200});
+static_assert(codes.size() == 4, "duplicates are kept once");
+static_assert(codes.order_of_key(404) == 2 && codes.order_of_key(0) == 0 && codes.order_of_key(1000) == 4, "");
+static_assert(*codes.find_by_order(3) == 500 && codes.find_by_order(4) == codes.end(), "");
+static_assert(codes.contains(301) && !codes.contains(302), "");
+
+const int MAX_KEYS = 1 << 16;
+int keys[MAX_KEYS];
+
+/**
+ * frozen sets of random keys built at runtime, every query is checked
+ * against std::lower_bound on a sorted copy, prints the first mismatch
+ */
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]);
+
+	std::mt19937 gen(seed);
+	static FrozenSet<int, MAX_KEYS> set(keys);
+
+	for (int round = 0; num_iterations > 0; ++round) {
+		int range = 1 + gen() % (2 * MAX_KEYS);
+		for (int& k : keys) k = gen() % range;
+		set = FrozenSet<int, MAX_KEYS>(keys);
+
+		vector<int> sorted(keys, keys + MAX_KEYS);
+		sort(sorted.begin(), sorted.end());
+		sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+		if (set.size() != sorted.size() || !equal(sorted.begin(), sorted.end(), set.begin())) {
+			cout << "round " << round << ": wrong keys" << endl;
+			return 1;
+		}
+
+		for (int i = 0; i < 100000 && num_iterations > 0; ++i, --num_iterations) {
+			int val = (int)(gen() % (range + 2)) - 1;
+			size_t rank = lower_bound(sorted.begin(), sorted.end(), val) - sorted.begin();
+			bool present = rank < sorted.size() && sorted[rank] == val;
+			size_t k = gen() % (sorted.size() + 1);
+			if (set.order_of_key(val) != rank || set.contains(val) != present
+				|| (present && set.find(val) != set.begin() + rank)
+				|| set.find_by_order(k) != set.begin() + k) {
+				cout << "round " << round << ": mismatch at key " << val << endl;
+				return 1;
+			}
+		}
+	}
+
+	cout << "OK" << endl;
+	return 0;
+}
\ No newline at end of file
@@ -1,11 +1,5 @@
-#include <ext/pb_ds/assoc_container.hpp>
-#include <ext/pb_ds/detail/standard_policies.hpp>
-#include <bits/stdc++.h>
+#include "ost_reference.cpp"
 
-using namespace std;
-using namespace __gnu_pbds;
-
-typedef tree<int, null_type, less<int>, rb_tree_tag, tree_order_statistics_node_update> ost;
-ost bst;
+ost_reference bst;
 
 #include "randomized_stress_test.cpp"
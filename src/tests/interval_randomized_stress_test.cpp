@@ -0,0 +1,64 @@
+#include <random>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]);
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> op_dist(1, 6);
+	std::uniform_int_distribution<int> num_dist(0, 1000000);
+	std::uniform_int_distribution<int> len_dist(0, 1000);
+
+	for (int i = 0; i < num_iterations; ++i) {
+		int operation = op_dist(gen);
+		int lo = num_dist(gen);
+		int hi = lo + len_dist(gen);
+
+		switch (operation) {
+			case 1: {
+					// Insert a random interval
+					intervals.insert(lo, hi);
+					break;
+				} case 2: {
+					// Erase the interval with the same start as a random one
+					auto it = intervals.find(lo, lo + (hi - lo) % 4);
+					if(it != intervals.end()) intervals.erase(it);
+					break;
+				} case 3: {
+					// Print size
+					cout << intervals.size() << endl;
+					break;
+				} case 4: {
+					// Count intervals overlapping a random range
+					cout << intervals.count_overlapping(lo, hi) << endl;
+					break;
+				} case 5: {
+					// Is a random point covered by some interval?
+					auto it = intervals.find_overlapping(lo);
+					if(it == intervals.end()) cout << "None" << endl;
+					else cout << ((*it).first <= lo && lo <= (*it).second) << endl;
+					break;
+				} case 6: {
+					// Report intervals overlapping a random range in order
+					long long count = 0;
+					unsigned long long hash = 0;
+					intervals.for_each_overlapping(lo, hi, [&](const pair<int,int>& p) {
+						count++;
+						hash = hash * 1000003 + p.first * 31 + p.second;
+					});
+					cout << count << " " << hash << endl;
+					break;
+				}
+		}
+	}
+
+	return 0;
+}
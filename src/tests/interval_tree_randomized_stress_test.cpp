@@ -0,0 +1,5 @@
+#include "../interval_tree.hpp"
+
+IntervalTree<int> intervals;
+
+#include "interval_randomized_stress_test.cpp"
\ No newline at end of file
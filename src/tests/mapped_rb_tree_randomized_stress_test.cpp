@@ -0,0 +1,62 @@
+#include "../mapped_rb_tree.hpp"
+
+#include <cstdint>
+#include <unistd.h>
+
+/**
+ * every member compiled with an unsigned key as well, the key type
+ * must not collide with the link type in overload resolution
+ */
+template class MappedRBTree<std::uint32_t>;
+template class MappedRBTree<unsigned long long>;
+
+/**
+ * MappedRBTree that closes and reopens its file every REOPEN_EVERY updates
+ * so that the stress test also checks that the tree survives a restart
+ */
+struct reopening_tree : MappedRBTree<int> {
+	static const int REOPEN_EVERY = 10000;
+	const char* path = "mapped_rb_tree_test.bin";
+	int updates = 0;
+
+	reopening_tree() {
+		unlink(path);
+		open(path);
+	}
+
+	/**
+	 * called before every update, so iterators taken before a reopen
+	 * are used after it, which works as long as links are file offsets
+	 */
+	void updating() {
+		if(++updates % REOPEN_EVERY == 0) {
+			close();
+			open(path);
+		}
+	}
+
+	decltype(auto) insert(int val) {
+		updating();
+		return MappedRBTree<int>::insert(val);
+	}
+
+	template<class A>
+	decltype(auto) erase(const A& a) {
+		updating();
+		return MappedRBTree<int>::erase(a);
+	}
+
+	bool erase_by_order(int k) {
+		updating();
+		return MappedRBTree<int>::erase_by_order(k);
+	}
+
+	~reopening_tree() {
+		close();
+		unlink(path);
+	}
+};
+
+reopening_tree bst;
+
+#include "randomized_stress_test.cpp"
\ No newline at end of file
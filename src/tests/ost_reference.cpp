@@ -0,0 +1,34 @@
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+
+#include <utility>
+#include <vector>
+
+typedef __gnu_pbds::tree<int, __gnu_pbds::null_type, std::less<int>, __gnu_pbds::rb_tree_tag,
+	__gnu_pbds::tree_order_statistics_node_update> ost;
+
+/**
+ * __gnu_pbds::tree as the reference of the stress tests
+ * the calls pbds does not have, answered with the plain pbds calls
+ */
+struct ost_reference : ost {
+	std::pair<ost::iterator, int> insert(int key) {
+		return std::make_pair(ost::insert(key).first, (int)order_of_key(key));
+	}
+
+	bool erase_by_order(int k) {
+		if(k < 0 || k >= (int)size()) return false;
+		erase(find_by_order(k));
+		return true;
+	}
+
+	void select_many(const std::vector<int>& ranks, std::vector<int>& out) {
+		out.clear();
+		for(int k : ranks) out.push_back(*find_by_order(k));
+	}
+
+	void rank_many(const std::vector<int>& keys, std::vector<int>& out) {
+		out.clear();
+		for(int k : keys) out.push_back(order_of_key(k));
+	}
+};
@@ -0,0 +1,146 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+#include "../wb_tree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * parallel_for_each and parallel_reduce checked against the sorted keys
+ * on 1 to 16 threads, prints the first mismatch
+ * - sizes from the empty tree over fewer keys than threads to trees cut
+ *   into several rank ranges (4096 keys per range at least)
+ * - the AVL and red-black trees also in lazy erase mode with many
+ *   tombstones left, which the scans must skip
+ * - parallel_for_each must visit every key exactly once, parallel_reduce
+ *   folds with an associative but not commutative op that records the
+ *   first and last key and whether the keys came in increasing order
+ */
+
+const unsigned THREADS[] = {1, 2, 3, 4, 7, 16};
+
+/**
+ * a run of keys: count, sum, first, last and whether it was increasing
+ */
+struct key_run {
+	long long count = 0, sum = 0;
+	int first = 0, last = 0;
+	bool increasing = true;
+
+	key_run() {}
+	key_run(int key) : count(1), sum(key), first(key), last(key) {}
+
+	bool operator==(const key_run& r) const {
+		return count == r.count && sum == r.sum && first == r.first && last == r.last && increasing == r.increasing;
+	}
+};
+
+key_run concat(const key_run& a, const key_run& b) {
+	if(a.count == 0) return b;
+	if(b.count == 0) return a;
+	key_run r;
+	r.count = a.count + b.count;
+	r.sum = a.sum + b.sum;
+	r.first = a.first;
+	r.last = b.last;
+	r.increasing = a.increasing && b.increasing && a.last < b.first;
+	return r;
+}
+
+template<class Tree>
+string check_scans(Tree& bst, const vector<int>& keys) {
+	key_run expected;
+	for(int key : keys) expected = concat(expected, key_run(key));
+
+	for(unsigned threads : THREADS) {
+		vector<atomic<int>> visits(keys.size());
+		atomic<int> stray(0);
+		bst.parallel_for_each([&](int key) {
+			auto it = lower_bound(keys.begin(), keys.end(), key);
+			if(it == keys.end() || *it != key) stray++;
+			else visits[it - keys.begin()]++;
+		}, threads);
+
+		if(stray != 0) return "parallel_for_each visited a key not in the tree on " + to_string(threads) + " threads";
+		for(size_t i = 0; i < keys.size(); i++) {
+			if(visits[i] != 1) return "parallel_for_each visited rank " + to_string(i) + " " + to_string(visits[i]) + " times on " + to_string(threads) + " threads";
+		}
+
+		key_run got = bst.parallel_reduce(key_run(), concat, threads);
+		if(!(got == expected)) return "parallel_reduce on " + to_string(threads) + " threads";
+	}
+	return "";
+}
+
+template<class Tree>
+void plain(Tree&) {}
+
+template<class Tree>
+void lazy_erase(Tree& bst) {
+	bst.set_lazy_erase(true, 0.9);
+}
+
+template<class Tree>
+bool check(const char* name, mt19937& gen, int rounds, void (*setup)(Tree&) = plain<Tree>) {
+	const int sizes[] = {0, 1, 3, 15, 5000, 9000, 40000};
+	for(int round = 0; round < rounds; round++) {
+		for(int size : sizes) {
+			Tree bst;
+			setup(bst);
+
+			// twice the keys, half of them erased again
+			vector<int> inserted;
+			for(int i = 0; i < 2 * size; i++) {
+				int key = gen() % (8 * size + 1);
+				bst.insert(key);
+				inserted.push_back(key);
+			}
+			shuffle(inserted.begin(), inserted.end(), gen);
+			for(int i = 0; i < size; i++) bst.erase(inserted[i]);
+
+			vector<int> keys;
+			for(auto it = bst.begin(); it != bst.end(); ++it) keys.push_back(*it);
+			if(keys.size() != bst.size() || !is_sorted(keys.begin(), keys.end())) {
+				cout << name << ": iteration does not match the size" << endl;
+				return false;
+			}
+
+			string error = check_scans(bst, keys);
+			if(!error.empty()) {
+				cout << name << ": " << error << ", size " << keys.size() << " in round " << round << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int rounds = max(1, std::atoi(argv[2]) / 500000);
+
+	mt19937 gen(seed);
+	if(!check<AVLTree<int>>("avl", gen, rounds)
+		|| !check<AVLTree<int>>("avl lazy erase", gen, rounds, lazy_erase)
+		|| !check<RBTree<int>>("rb", gen, rounds)
+		|| !check<RBTree<int>>("rb lazy erase", gen, rounds, lazy_erase)
+		|| !check<splay_tree<int>>("splay", gen, rounds)
+		|| !check<WBTree<int>>("wb", gen, rounds)) {
+		return 1;
+	}
+
+	cout << "OK" << endl;
+	return 0;
+}
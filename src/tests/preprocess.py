@@ -1,17 +1,27 @@
+import os
 import sys
 import re
 
-def replace_include_with_file_contents(file_path):
+def replace_include_with_file_contents(file_path, included=None):
+    if included is None:
+        included = set()
+
     with open(file_path, 'r') as file:
         content = file.read()
-    
+
     def include_replace(match):
-        include_file_path = match.group(1)
+        include_file_path = os.path.join(os.path.dirname(file_path), match.group(1))
+        real_path = os.path.realpath(include_file_path)
+        # headers guarded by #pragma once are only inlined the first time
+        if real_path in included:
+            return ''
         with open(include_file_path, 'r') as include_file:
-            return include_file.read()
-    
+            if re.search(r'^#pragma\s+once', include_file.read(), re.MULTILINE):
+                included.add(real_path)
+        return re.sub(r'^#pragma\s+once\s*$', '', replace_include_with_file_contents(include_file_path, included), flags=re.MULTILINE)
+
     replaced_content = re.sub(r'#include\s+"(.+?)"', include_replace, content)
-    
+
     return replaced_content
 
 # Check if the file path is provided as a command line argument
@@ -22,4 +32,3 @@ if len(sys.argv) < 2:
 file_path = sys.argv[1]
 new_content = replace_include_with_file_contents(file_path)
 print(new_content)
-
@@ -0,0 +1,77 @@
+#include <random>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * nearest rank on a small window, quantile(q) is the ceil(q * n)th
+ * smallest event, e.g. q = 0.9 of 4 events is the maximum
+ * leaves the 4 events in stream 0
+ */
+bool check_quantile_definition() {
+	const int values[] = {40, 10, 30, 20};
+	const double qs[] = {0, 0.1, 0.25, 0.26, 0.5, 0.51, 0.75, 0.9, 1};
+	const int expected[] = {10, 10, 10, 20, 20, 30, 30, 40, 40};
+	for(int v : values) streams.push(0, v, 0, 1);
+	for(int i = 0; i < 9; i++) {
+		if(streams.quantile(0, qs[i]) != expected[i]) {
+			cerr << "quantile(" << qs[i] << ") of 10 20 30 40 is " << streams.quantile(0, qs[i]) << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]);
+
+	if(!check_quantile_definition()) return 1;
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> op_dist(1, 6);
+	std::uniform_int_distribution<int> stream_dist(0, 15);
+	std::uniform_int_distribution<int> value_dist(0, 100);
+	std::uniform_int_distribution<int> q_dist(0, 100);
+	long long now = 0;
+
+	for (int i = 0; i < num_iterations; ++i) {
+		int operation = op_dist(gen);
+		int stream = stream_dist(gen);
+		now += gen() % 3;
+
+		switch (operation) {
+			case 1:
+			case 2: {
+					// Push a random value, small values so that duplicates are common
+					streams.push(stream, value_dist(gen), now, 1 + gen() % 3);
+					break;
+				} case 3: {
+					// Print size
+					cout << streams.stream(stream).size() << endl;
+					break;
+				} case 4: {
+					// Print a random quantile
+					double q = q_dist(gen) / 100.0;
+					if(streams.stream(stream).empty()) cout << "None" << endl;
+					else cout << streams.quantile(stream, q) << endl;
+					break;
+				} case 5: {
+					// Number of events smaller than a random value
+					cout << streams.stream(stream).order_of_key(value_dist(gen)) << endl;
+					break;
+				} case 6: {
+					// Expire old events in all streams
+					streams.expire(now);
+					break;
+				}
+		}
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -1,8 +1,13 @@
-#include <random>
+#include "stress_operations.cpp"
+
 #include <iostream>
 
 using namespace std;
 
+/**
+ * prints every result on a line of its own, to be diffed with the output
+ * of gnu_ost_randomized_stress_test.cpp
+ */
 int main(int argc, char* argv[]) {
 	if (argc < 3) {
 		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
@@ -12,49 +17,9 @@ int main(int argc, char* argv[]) {
 	int seed = std::atoi(argv[1]);
 	int num_iterations = std::atoi(argv[2]);
 
-	std::mt19937 gen(seed);
-	std::uniform_int_distribution<int> op_dist(1, 5);
-	std::uniform_int_distribution<int> num_dist(-10000000, 10000000);
-
-	// Create an instance of your order statistic tree
-
-	for (int i = 0; i < num_iterations; ++i) {
-		int operation = op_dist(gen);
-
-		switch (operation) {
-			case 1: {
-					// Insert a random number into the order statistic tree
-					int num = num_dist(gen);
-					bst.insert(num);
-					break;
-				} case 2: {
-					// Delete a random number from the order statistic tree
-					int num = num_dist(gen);
-					auto it = bst.find(num);
-					if(it != bst.end() &&  bst.size()>0) bst.erase(it);
-					break;
-				} case 3: {
-					// Print size of the tree
-					cout << bst.size() << endl;
-					break;
-				} case 4: {
-					// Find the kth smallest element in the order statistic tree
-					if(bst.size()==0) {
-						cout << "None" << endl;
-						break;
-					}
-					uniform_int_distribution<int> k_dist(0, bst.size()-1);
-					int k = k_dist(gen);
-					cout << *bst.find_by_order(k) << endl;
-					break;
-				} case 5: {
-					// Find the number of elements smaller than value k
-					int k = num_dist(gen);
-					cout << bst.order_of_key(k) << endl;
-					break;
-				}
-		}
-	}
+	run_operations(bst, seed, num_iterations, [](int, const auto& result) {
+		cout << result << '\n';
+	});
 
 	return 0;
 }
@@ -0,0 +1,69 @@
+#include <random>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]);
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> op_dist(1, 9);
+	std::uniform_int_distribution<int> num_dist(-1000, 1000);
+
+	for (int i = 0; i < num_iterations; ++i) {
+		int operation = op_dist(gen);
+
+		if (operation <= 2) {
+			// Insert a random number at a random position
+			uniform_int_distribution<int> pos_dist(0, seq.size());
+			int pos = pos_dist(gen);
+			seq.insert_at(pos, num_dist(gen));
+			continue;
+		}
+
+		if (seq.size()==0) {
+			cout << "None" << endl;
+			continue;
+		}
+
+		// A random non empty range [first,last)
+		uniform_int_distribution<int> pos_dist(0, seq.size()-1);
+		int first = pos_dist(gen);
+		int last = pos_dist(gen);
+		if (first > last) swap(first, last);
+		last++;
+
+		switch (operation) {
+			case 3: {
+					seq.erase_at(first);
+					break;
+				} case 4: {
+					cout << seq.at(first) << endl;
+					break;
+				} case 5: {
+					seq.reverse(first, last);
+					break;
+				} case 6: {
+					seq.add(first, last, num_dist(gen));
+					break;
+				} case 7: {
+					seq.assign(first, last, num_dist(gen));
+					break;
+				} case 8: {
+					cout << seq.sum(first, last) << endl;
+					break;
+				} case 9: {
+					cout << seq.min(first, last) << " " << seq.max(first, last) << endl;
+					break;
+				}
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,6 @@
+#include "../rb_tree.hpp"
+#include "relayouting_tree.cpp"
+
+relayouting_tree<RBTree<int>> bst;
+
+#include "randomized_stress_test.cpp"
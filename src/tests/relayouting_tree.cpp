@@ -0,0 +1,45 @@
+#include "../relayout.hpp"
+
+/**
+ * Tree that runs relayout passes behind the stress test: every update is
+ * followed by a step of STEP nodes, the next pass, alternating between the
+ * policies, is planned as soon as one completes, and every FULL_EVERY
+ * updates the whole tree is moved at once.
+ * Steps run after the update, since they invalidate iterators.
+ */
+template<class Tree>
+struct relayouting_tree : Tree {
+	static const int STEP = 16;
+	static const int FULL_EVERY = 100000;
+	int updates = 0;
+	int passes = 0;
+
+	void updated() {
+		if(++updates % FULL_EVERY == 0) {
+			Tree::relayout(updates / FULL_EVERY % 2 ? breadth_first : van_emde_boas);
+		} else if(Tree::relayout_step(STEP)) {
+			Tree::begin_relayout(passes++ % 2 ? breadth_first : van_emde_boas);
+		}
+	}
+
+	struct step_after {
+		relayouting_tree* t;
+		~step_after() {t->updated();}
+	};
+
+	decltype(auto) insert(int val) {
+		step_after s{this};
+		return Tree::insert(val);
+	}
+
+	template<class A>
+	decltype(auto) erase(const A& a) {
+		step_after s{this};
+		return Tree::erase(a);
+	}
+
+	bool erase_by_order(int k) {
+		step_after s{this};
+		return Tree::erase_by_order(k);
+	}
+};
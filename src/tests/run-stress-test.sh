@@ -4,6 +4,13 @@ set -xe
 SEED=0
 NUM_TESTS=1000000
 
+# All trees against the pbds reference in one process, prints ops/s per tree
+python3 preprocess.py differential_stress_test.cpp > differential_test.cpp
+g++ -std=c++14 -o differential_test.out -O3 -pthread differential_test.cpp
+time ./differential_test.out $SEED $NUM_TESTS 4
+
+
+# The text driver prints every result, for diffs of the exact operation
 python3 preprocess.py gnu_ost_randomized_stress_test.cpp > gnu_ost.cpp
 g++ -std=c++14 -o gnu_ost.out -O3 gnu_ost.cpp
 time ./gnu_ost.out $SEED $NUM_TESTS > original_out.txt 
@@ -31,5 +38,124 @@ time ./splay_test.out $SEED $NUM_TESTS > splay_test.txt
 diff original_out.txt splay_test.txt
 
 
+# Weight-Balanced Tree: test diff with gnu-test
+python3 preprocess.py wb_tree_randomized_stress_test.cpp > wb_test.cpp
+g++ -std=c++14 -o wb_test.out -O3 wb_test.cpp
+time ./wb_test.out $SEED $NUM_TESTS > wb_test.txt
+diff original_out.txt wb_test.txt
+
+
+# Memory mapped Red-Black Tree: test diff with gnu-test, the tree is reopened from its file periodically
+python3 preprocess.py mapped_rb_tree_randomized_stress_test.cpp > mapped_rb_test.cpp
+g++ -std=c++14 -o mapped_rb_test.out -O3 mapped_rb_test.cpp
+time ./mapped_rb_test.out $SEED $NUM_TESTS > mapped_rb_test.txt
+diff original_out.txt mapped_rb_test.txt
+
+
+# Relayout: AVL, red-black and splay trees moving their nodes in small steps between updates, test diff with gnu-test
+for tree in avl_tree rb_tree splay_tree; do
+python3 preprocess.py ${tree}_relayout_randomized_stress_test.cpp > ${tree}_relayout_test.cpp
+g++ -std=c++14 -o ${tree}_relayout_test.out -O3 ${tree}_relayout_test.cpp
+time ./${tree}_relayout_test.out $SEED $NUM_TESTS > ${tree}_relayout_test.txt
+diff original_out.txt ${tree}_relayout_test.txt
+done
+
+
+
+
+
+
+# Sequences: test diff with a std::vector based sequence
+python3 preprocess.py vector_sequence_randomized_stress_test.cpp > vector_sequence.cpp
+g++ -std=c++14 -o vector_sequence.out -O3 vector_sequence.cpp
+time ./vector_sequence.out $SEED $NUM_TESTS > original_sequence_out.txt
+
+python3 preprocess.py avl_sequence_randomized_stress_test.cpp > avl_sequence_test.cpp
+g++ -std=c++14 -o avl_sequence_test.out -O3 avl_sequence_test.cpp
+time ./avl_sequence_test.out $SEED $NUM_TESTS > avl_sequence_test.txt
+diff original_sequence_out.txt avl_sequence_test.txt
+
+python3 preprocess.py splay_sequence_randomized_stress_test.cpp > splay_sequence_test.cpp
+g++ -std=c++14 -o splay_sequence_test.out -O3 splay_sequence_test.cpp
+time ./splay_sequence_test.out $SEED $NUM_TESTS > splay_sequence_test.txt
+diff original_sequence_out.txt splay_sequence_test.txt
+
+
+# Range sequences: test diff with a std::vector based range sequence
+python3 preprocess.py vector_range_sequence_randomized_stress_test.cpp > vector_range_sequence.cpp
+g++ -std=c++14 -o vector_range_sequence.out -O3 vector_range_sequence.cpp
+time ./vector_range_sequence.out $SEED $NUM_TESTS > original_range_out.txt
+
+python3 preprocess.py splay_range_sequence_randomized_stress_test.cpp > splay_range_sequence_test.cpp
+g++ -std=c++14 -o splay_range_sequence_test.out -O3 splay_range_sequence_test.cpp
+time ./splay_range_sequence_test.out $SEED $NUM_TESTS > splay_range_sequence_test.txt
+diff original_range_out.txt splay_range_sequence_test.txt
+
+
+# Interval tree: test diff with a brute force scan, fewer iterations since every query is O(n) there
+python3 preprocess.py brute_force_interval_randomized_stress_test.cpp > brute_force_interval.cpp
+g++ -std=c++14 -o brute_force_interval.out -O3 brute_force_interval.cpp
+time ./brute_force_interval.out $SEED $((NUM_TESTS / 10)) > original_interval_out.txt
+
+python3 preprocess.py interval_tree_randomized_stress_test.cpp > interval_tree_test.cpp
+g++ -std=c++14 -o interval_tree_test.out -O3 interval_tree_test.cpp
+time ./interval_tree_test.out $SEED $((NUM_TESTS / 10)) > interval_tree_test.txt
+diff original_interval_out.txt interval_tree_test.txt
+
+
+# Dominance counter: test diff with a brute force scan
+python3 preprocess.py brute_force_dominance_randomized_stress_test.cpp > brute_force_dominance.cpp
+g++ -std=c++14 -o brute_force_dominance.out -O3 brute_force_dominance.cpp
+time ./brute_force_dominance.out $SEED $((NUM_TESTS / 20)) > original_dominance_out.txt
+
+python3 preprocess.py dominance_counter_randomized_stress_test.cpp > dominance_counter_test.cpp
+g++ -std=c++14 -o dominance_counter_test.out -O3 dominance_counter_test.cpp
+time ./dominance_counter_test.out $SEED $((NUM_TESTS / 20)) > dominance_counter_test.txt
+diff original_dominance_out.txt dominance_counter_test.txt
+
+
+# Frozen set: checks itself against std::lower_bound, compile time checks are static_asserts
+python3 preprocess.py frozen_set_randomized_stress_test.cpp > frozen_set_test.cpp
+g++ -std=c++14 -o frozen_set_test.out -O3 frozen_set_test.cpp
+time ./frozen_set_test.out $SEED $NUM_TESTS
+
+
+# String keys with inline key prefixes: checks itself against a pbds tree
+python3 preprocess.py string_key_randomized_stress_test.cpp > string_key_test.cpp
+g++ -std=c++14 -o string_key_test.out -O3 string_key_test.cpp
+time ./string_key_test.out $SEED $NUM_TESTS
+
+
+# Memory and shape introspection: checks itself, exact against approximate and against the bounds of every tree
+python3 preprocess.py tree_stats_randomized_stress_test.cpp > tree_stats_test.cpp
+g++ -std=c++14 -o tree_stats_test.out -O3 tree_stats_test.cpp
+time ./tree_stats_test.out $SEED $NUM_TESTS
+
+
+
+# Parallel scans: parallel_for_each and parallel_reduce on 1 to 16 threads, checks itself against a sequential scan
+python3 preprocess.py parallel_traversal_randomized_stress_test.cpp > parallel_traversal_test.cpp
+g++ -std=c++14 -o parallel_traversal_test.out -O3 -pthread parallel_traversal_test.cpp
+time ./parallel_traversal_test.out $SEED $NUM_TESTS
+
+# Flat combining: threads update disjoint keys and then query, checks itself against std::set
+python3 preprocess.py flat_combining_randomized_stress_test.cpp > flat_combining_test.cpp
+g++ -std=c++14 -o flat_combining_test.out -O3 -pthread flat_combining_test.cpp
+time ./flat_combining_test.out $SEED $NUM_TESTS
+
+
+
+# Key updates: in place or relinked, checks itself against erase + insert on a pbds tree
+python3 preprocess.py update_key_randomized_stress_test.cpp > update_key_test.cpp
+g++ -std=c++14 -o update_key_test.out -O3 update_key_test.cpp
+time ./update_key_test.out $SEED $NUM_TESTS
 
+# Sliding quantiles: test diff with a brute force window that sorts on every query
+python3 preprocess.py brute_force_quantile_randomized_stress_test.cpp > brute_force_quantile.cpp
+g++ -std=c++14 -o brute_force_quantile.out -O3 brute_force_quantile.cpp
+time ./brute_force_quantile.out $SEED $NUM_TESTS > original_quantile_out.txt
 
+python3 preprocess.py sliding_quantile_randomized_stress_test.cpp > sliding_quantile_test.cpp
+g++ -std=c++14 -o sliding_quantile_test.out -O3 sliding_quantile_test.cpp
+time ./sliding_quantile_test.out $SEED $NUM_TESTS > sliding_quantile_test.txt
+diff original_quantile_out.txt sliding_quantile_test.txt
@@ -0,0 +1,62 @@
+#include <random>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]);
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> op_dist(1, 6);
+	std::uniform_int_distribution<int> num_dist(-10000000, 10000000);
+
+	for (int i = 0; i < num_iterations; ++i) {
+		int operation = op_dist(gen);
+
+		switch (operation) {
+			case 1:
+			case 2: {
+					// Insert a random number at a random position
+					uniform_int_distribution<int> pos_dist(0, seq.size());
+					int pos = pos_dist(gen);
+					seq.insert_at(pos, num_dist(gen));
+					break;
+				} case 3: {
+					// Erase the element at a random position
+					if(seq.size()==0) break;
+					uniform_int_distribution<int> pos_dist(0, seq.size()-1);
+					seq.erase_at(pos_dist(gen));
+					break;
+				} case 4: {
+					// Print size of the sequence
+					cout << seq.size() << endl;
+					break;
+				} case 5: {
+					// Print the element at a random position
+					if(seq.size()==0) {
+						cout << "None" << endl;
+						break;
+					}
+					uniform_int_distribution<int> pos_dist(0, seq.size()-1);
+					cout << seq.at(pos_dist(gen)) << endl;
+					break;
+				} case 6: {
+					// Split at a random position and concatenate the halves back in order
+					uniform_int_distribution<int> pos_dist(0, seq.size());
+					int pos = pos_dist(gen);
+					seq.split_at(pos, rest);
+					cout << seq.size() << " " << rest.size() << endl;
+					seq.concat(rest);
+					break;
+				}
+		}
+	}
+
+	return 0;
+}
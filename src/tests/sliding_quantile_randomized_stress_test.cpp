@@ -0,0 +1,5 @@
+#include "../sliding_quantile.hpp"
+
+sliding_quantile_streams<int> streams(64, 1500);
+
+#include "quantile_randomized_stress_test.cpp"
\ No newline at end of file
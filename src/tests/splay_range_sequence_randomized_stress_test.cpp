@@ -0,0 +1,5 @@
+#include "../splay_range_sequence.hpp"
+
+splay_range_sequence<long long> seq;
+
+#include "range_sequence_randomized_stress_test.cpp"
\ No newline at end of file
@@ -0,0 +1,5 @@
+#include "../splay_sequence.hpp"
+
+splay_sequence<int> seq, rest;
+
+#include "sequence_randomized_stress_test.cpp"
\ No newline at end of file
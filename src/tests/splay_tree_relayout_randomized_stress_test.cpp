@@ -0,0 +1,6 @@
+#include "../splay_tree.hpp"
+#include "relayouting_tree.cpp"
+
+relayouting_tree<splay_tree<int>> bst;
+
+#include "randomized_stress_test.cpp"
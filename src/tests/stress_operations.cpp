@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+/**
+ * The operations of the randomized stress test, shared by the text driver
+ * (randomized_stress_test.cpp) and the in process differential harness
+ * (differential_stress_test.cpp). The seed fixes the operations, every
+ * result is passed to out(i,result), i being the index of the operation
+ * that produced it. A result is an integer, or "None" for a query the
+ * empty tree can't answer.
+ */
+template<class Tree,class Out>
+void run_operations(Tree& bst,int seed,int num_iterations,Out out) {
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> op_dist(1, 7);
+	std::uniform_int_distribution<int> num_dist(-10000000, 10000000);
+
+	for (int i = 0; i < num_iterations; ++i) {
+		int operation = op_dist(gen);
+
+		switch (operation) {
+			case 1: {
+					// Insert a random number into the order statistic tree, its rank
+					int num = num_dist(gen);
+					out(i, bst.insert(num).second);
+					break;
+				} case 2: {
+					// Delete a random number from the order statistic tree
+					// through an iterator or by key
+					int num = num_dist(gen);
+					if(num & 1) {
+						auto it = bst.find(num);
+						if(it != bst.end() &&  bst.size()>0) bst.erase(it);
+					} else {
+						out(i, bst.erase(num));
+					}
+					break;
+				} case 3: {
+					// Size of the tree
+					out(i, bst.size());
+					break;
+				} case 4: {
+					// Find the kth smallest element in the order statistic tree
+					if(bst.size()==0) {
+						out(i, "None");
+						break;
+					}
+					std::uniform_int_distribution<int> k_dist(0, bst.size()-1);
+					int k = k_dist(gen);
+					out(i, *bst.find_by_order(k));
+					break;
+				} case 5: {
+					// Find the number of elements smaller than value k
+					int k = num_dist(gen);
+					out(i, bst.order_of_key(k));
+					break;
+				} case 6: {
+					// Batched find_by_order and order_of_key on a few sorted random queries
+					if(bst.size()==0) {
+						out(i, "None");
+						break;
+					}
+					std::uniform_int_distribution<int> k_dist(0, bst.size()-1);
+					std::vector<int> ranks(4), keys(4), selected, rank;
+					for(int& k : ranks) k = k_dist(gen);
+					for(int& k : keys) k = num_dist(gen);
+					std::sort(ranks.begin(), ranks.end());
+					std::sort(keys.begin(), keys.end());
+					bst.select_many(ranks, selected);
+					bst.rank_many(keys, rank);
+					unsigned long long hash = 0;
+					for(int v : selected) hash = hash * 1000003 + v;
+					for(int v : rank) hash = hash * 1000003 + v;
+					out(i, hash);
+					break;
+				} case 7: {
+					// Delete the kth smallest element, k is out of range half of the time
+					std::uniform_int_distribution<int> k_dist(0, 2 * bst.size());
+					out(i, bst.erase_by_order(k_dist(gen)));
+					break;
+				}
+		}
+	}
+}
@@ -0,0 +1,127 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <random>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+typedef __gnu_pbds::tree<string, __gnu_pbds::null_type, less<string>, __gnu_pbds::rb_tree_tag,
+	__gnu_pbds::tree_order_statistics_node_update> reference;
+
+/**
+ * checked against a pbds tree of the same keys, prints the first mismatch
+ * std::string keys use the inline key prefixes, keys are drawn so that
+ * prefixes often tie: a few shared stems of up to 20 bytes, a small
+ * alphabet with '\0' and '\xff', and keys that are prefixes of each other
+ * on the std::less<> trees find and order_of_key are also called with
+ * other key types
+ */
+string random_key(mt19937& gen) {
+	static const string stems[] = {"", "https://", "https://www.exam", "https://www.example.c", string(10, '\0')};
+	static const char alphabet[] = {'\0', 'a', 'b', '\xff'};
+	string key = stems[gen() % 5];
+	int len = gen() % 8;
+	for (int i = 0; i < len; ++i) key += alphabet[gen() % 4];
+	return key;
+}
+
+/**
+ * a key that std::less<> compares with std::string without building one,
+ * so the heterogeneous overloads are taken
+ */
+struct key_view {
+	const char* data;
+	size_t len;
+
+	int compare(const string& s) const {return -s.compare(0, string::npos, data, len);}
+};
+
+bool operator<(const string& a, const key_view& b) {return b.compare(a) > 0;}
+bool operator<(const key_view& a, const string& b) {return a.compare(b) < 0;}
+
+/**
+ * find and order_of_key with a key_view, and with a const char* when the
+ * key has no '\0', on the trees with a transparent comparator
+ */
+template<template<class, class> class Tree>
+bool check_heterogeneous(Tree<string, std::less<>>& bst, reference& ref, const string& key) {
+	bool present = ref.find(key) != ref.end();
+	int rank = ref.order_of_key(key);
+	key_view view{key.data(), key.size()};
+	if((bst.find(view) != bst.end()) != present || bst.order_of_key(view) != rank) return false;
+	if(key.find('\0') != string::npos) return true;
+	return (bst.find(key.c_str()) != bst.end()) == present && bst.order_of_key(key.c_str()) == rank;
+}
+
+template<class Tree>
+bool check_heterogeneous(Tree&, reference&, const string&) {
+	return true;
+}
+
+template<class Tree>
+bool check(const char* name, Tree& bst, reference& ref, mt19937& gen, int num_iterations) {
+	for (int i = 0; i < num_iterations; ++i) {
+		string key = random_key(gen);
+		int rank = ref.order_of_key(key);
+		bool ok = true;
+
+		switch (gen() % 5) {
+			case 0:
+				ok = bst.insert(key).second == rank;
+				ref.insert(key);
+				break;
+			case 1:
+				ok = bst.erase(key) == (ref.erase(key) == 1);
+				break;
+			case 2:
+				ok = (bst.find(key) != bst.end()) == (ref.find(key) != ref.end()) && check_heterogeneous(bst, ref, key);
+				break;
+			case 3:
+				ok = bst.order_of_key(key) == rank && check_heterogeneous(bst, ref, key);
+				break;
+			case 4:
+				if (!ref.empty()) {
+					int k = gen() % ref.size();
+					ok = *bst.find_by_order(k) == *ref.find_by_order(k);
+				}
+				break;
+		}
+
+		if (!ok || bst.size() != ref.size()) {
+			cout << name << ": mismatch at iteration " << i << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]) / 4;
+
+	mt19937 gen(seed);
+	AVLTree<string> avl;
+	AVLTree<string, std::less<>> avl_transparent;
+	RBTree<string> rb;
+	RBTree<string, std::less<>> rb_transparent;
+	reference avl_ref, avl_transparent_ref, rb_ref, rb_transparent_ref;
+
+	if (!check("avl", avl, avl_ref, gen, num_iterations)
+		|| !check("avl less<>", avl_transparent, avl_transparent_ref, gen, num_iterations)
+		|| !check("rb", rb, rb_ref, gen, num_iterations)
+		|| !check("rb less<>", rb_transparent, rb_transparent_ref, gen, num_iterations)) {
+		return 1;
+	}
+
+	cout << "OK" << endl;
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+#include "../wb_tree.hpp"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+/**
+ * memory_usage and shape_stats checked against each other and against the
+ * bounds of every tree, prints the first violation
+ * - the exact and approximate node counts, block and heap nodes agree,
+ *   the histogram sums to the node count and fits a binary tree
+ * - the max depth agrees where the tree keeps heights, and satisfies the
+ *   tree's own bound (AVL, red-black with its black height, weight balanced)
+ * - after a relayout every node is in a block
+ */
+
+const int CHECK_EVERY = 1000;
+const int RELAYOUT_EVERY = 50000;
+const int KEYS = 1 << 14;
+
+string check_stats(const tree_memory_usage& approximate, const tree_memory_usage& exact,
+	const tree_shape_stats& shape, const tree_shape_stats& sampled, size_t nodes) {
+	if(exact.nodes != nodes || approximate.nodes != nodes) return "memory node count";
+	if(exact.block_nodes != approximate.block_nodes || exact.heap_nodes != approximate.heap_nodes) return "block and heap nodes";
+	for(const tree_memory_usage* m : {&approximate, &exact}) {
+		if(m->node_bytes != m->nodes * m->node_size) return "node bytes";
+		if(m->total_bytes != m->node_bytes + m->allocator_overhead + m->auxiliary_bytes) return "total bytes";
+		if(m->heap_nodes > 0 && m->allocator_overhead == 0) return "allocator overhead";
+	}
+
+	if(shape.nodes != nodes || sampled.nodes != nodes) return "shape node count";
+	if(nodes == 0) return shape.max_depth == -1 && sampled.max_depth == -1 ? "" : "depth of an empty tree";
+
+	size_t sum = 0;
+	for(size_t d = 0; d < shape.depth_histogram.size(); d++) {
+		size_t count = shape.depth_histogram[d];
+		if(count == 0 || (d < 62 && count > (1ULL << d))) return "depth histogram";
+		sum += count;
+	}
+	if(sum != nodes || (int)shape.depth_histogram.size() != shape.max_depth + 1) return "depth histogram sum";
+	if(shape.average_depth < 0 || shape.average_depth > shape.max_depth) return "average depth";
+
+	sum = 0;
+	for(size_t count : sampled.depth_histogram) sum += count;
+	if(sum + 64 < nodes || sum > nodes + 64) return "sampled histogram sum";
+	if(sampled.average_depth < 0 || sampled.average_depth > shape.max_depth) return "sampled average depth";
+	if(sampled.max_depth > shape.max_depth) return "sampled max depth";
+	if(shape.rotations != sampled.rotations) return "rotations";
+	return "";
+}
+
+/**
+ * relayouts the tree, false for a tree that has no relayout
+ */
+template<class Tree>
+bool relayout(Tree& bst, relayout_policy policy) {
+	bst.relayout(policy);
+	return true;
+}
+
+bool relayout(WBTree<int>&, relayout_policy) {
+	return false;
+}
+
+template<class Tree>
+bool check(const char* name, Tree& bst, mt19937& gen, int num_iterations, bool keeps_heights,
+	double depth_bound_factor, bool red_black = false) {
+	unsigned long long rotations = 0;
+
+	for(int i = 1; i <= num_iterations; i++) {
+		int key = gen() % KEYS;
+		switch(gen() % 4) {
+			case 0: case 1: bst.insert(key); break;
+			case 2: bst.erase(key); break;
+			case 3: bst.erase_by_order(gen() % (bst.size() + 1)); break;
+		}
+
+		if(i % RELAYOUT_EVERY == 0 && relayout(bst, i / RELAYOUT_EVERY % 2 ? van_emde_boas : breadth_first)) {
+			tree_memory_usage m = bst.memory_usage(stats_exact);
+			if(m.heap_nodes != 0 || m.block_nodes != m.nodes) {
+				cout << name << ": nodes outside the block after a relayout at iteration " << i << endl;
+				return false;
+			}
+		}
+		if(i % CHECK_EVERY != 0) continue;
+
+		tree_shape_stats shape = bst.shape_stats(stats_exact);
+		tree_shape_stats sampled = bst.shape_stats();
+		size_t nodes = shape.nodes; // tombstones included, compared with the memory walk
+		string error = check_stats(bst.memory_usage(), bst.memory_usage(stats_exact), shape, sampled, nodes);
+
+		double bound = depth_bound_factor * log2(bst.size() + 2.0);
+		if(error.empty() && bst.size() > 0 && shape.max_depth + 1 > bound) error = "depth bound";
+		if(error.empty() && keeps_heights && sampled.max_depth != shape.max_depth) error = "max depth";
+		if(error.empty() && red_black && nodes > 0
+			&& (shape.black_height > shape.max_depth + 1 || shape.max_depth + 1 > 2 * shape.black_height
+				|| shape.black_height != sampled.black_height)) {
+			error = "black height";
+		}
+		if(error.empty() && !red_black && shape.black_height != -1) error = "black height";
+		if(error.empty() && shape.rotations < rotations) error = "rotations went down";
+		rotations = shape.rotations;
+
+		if(!error.empty()) {
+			cout << name << ": " << error << " at iteration " << i << endl;
+			return false;
+		}
+	}
+
+	if(bst.size() > 1 && rotations == 0) {
+		cout << name << ": no rotations counted" << endl;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]) / 5;
+
+	mt19937 gen(seed);
+	AVLTree<int> avl, lazy_avl;
+	lazy_avl.set_lazy_erase(true);
+	RBTree<int> rb;
+	splay_tree<int> splay;
+	WBTree<int> wb;
+
+	// a splay tree has no depth bound
+	if (!check("avl", avl, gen, num_iterations, true, 1.45)
+		|| !check("avl lazy erase", lazy_avl, gen, num_iterations, true, 1.45)
+		|| !check("rb", rb, gen, num_iterations, true, 2.0, true)
+		|| !check("splay", splay, gen, num_iterations, true, KEYS)
+		|| !check("wb", wb, gen, num_iterations, false, 2.5)) {
+		return 1;
+	}
+
+	cout << "OK" << endl;
+	return 0;
+}
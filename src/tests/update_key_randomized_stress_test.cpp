@@ -0,0 +1,117 @@
+#include "../avl_tree.hpp"
+#include "../rb_tree.hpp"
+#include "../splay_tree.hpp"
+#include "../wb_tree.hpp"
+
+#include <ext/pb_ds/assoc_container.hpp>
+#include <ext/pb_ds/tree_policy.hpp>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+typedef __gnu_pbds::tree<int, __gnu_pbds::null_type, less<int>, __gnu_pbds::rb_tree_tag,
+	__gnu_pbds::tree_order_statistics_node_update> reference;
+
+/**
+ * update_key checked against erase + insert on a pbds tree, prints the first mismatch
+ * - half of the updates move the key by a little, so that many stay between
+ *   their neighbours and are done in place, the rest move it anywhere
+ * - the returned rank, -1 when the new key is taken, and that the iterator
+ *   still points at the same node, now holding the new key
+ * - inserts, erases and order statistics in between check the structure
+ */
+
+const int KEYS = 1 << 12;
+
+template<class Tree>
+bool check(const char* name, Tree& bst, mt19937& gen, int num_iterations) {
+	reference ref;
+	for(int i = 0; i < num_iterations; i++) {
+		int key = gen() % KEYS;
+		bool ok = true;
+
+		switch(gen() % 6) {
+			case 0:
+				ok = bst.insert(key).second == (int)ref.order_of_key(key);
+				ref.insert(key);
+				break;
+			case 1:
+				ok = bst.erase(key) == (ref.erase(key) == 1);
+				break;
+			case 2: case 3: {
+				if(ref.empty()) break;
+				int k = gen() % ref.size();
+				int old_key = *ref.find_by_order(k);
+				int new_key = gen() % 2 ? old_key + (int)(gen() % 9) - 4 : key;
+				auto it = bst.find(old_key);
+				int rank = bst.update_key(it, new_key);
+
+				if(new_key != old_key && ref.find(new_key) != ref.end()) {
+					ok = rank == -1 && *it == old_key;
+				} else {
+					ref.erase(old_key);
+					ref.insert(new_key);
+					ok = rank == (int)ref.order_of_key(new_key) && *it == new_key && bst.find(new_key) == it;
+				}
+				break;
+			}
+			case 4:
+				ok = bst.order_of_key(key) == (int)ref.order_of_key(key);
+				break;
+			case 5:
+				if(!ref.empty()) {
+					int k = gen() % ref.size();
+					ok = *bst.find_by_order(k) == *ref.find_by_order(k);
+				}
+				break;
+		}
+
+		if(!ok || bst.size() != ref.size()) {
+			cout << name << ": mismatch at iteration " << i << endl;
+			return false;
+		}
+	}
+
+	int k = 0;
+	for(auto it = bst.begin(); it != bst.end(); ++it, k++) {
+		if(*it != *ref.find_by_order(k)) {
+			cout << name << ": contents differ at rank " << k << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		cerr << "Usage: " << argv[0] << " <random_seed> <num_iterations>\n";
+		return 1;
+	}
+
+	int seed = std::atoi(argv[1]);
+	int num_iterations = std::atoi(argv[2]) / 6;
+
+	mt19937 gen(seed);
+	AVLTree<int> avl;
+	AVLTree<int> avl_lazy;
+	avl_lazy.set_lazy_erase(true);
+	RBTree<int> rb;
+	RBTree<int> rb_lazy;
+	rb_lazy.set_lazy_erase(true);
+	splay_tree<int> splay;
+	WBTree<int> wb;
+
+	if(!check("avl", avl, gen, num_iterations)
+		|| !check("avl lazy erase", avl_lazy, gen, num_iterations)
+		|| !check("rb", rb, gen, num_iterations)
+		|| !check("rb lazy erase", rb_lazy, gen, num_iterations)
+		|| !check("splay", splay, gen, num_iterations)
+		|| !check("wb", wb, gen, num_iterations)) {
+		return 1;
+	}
+
+	cout << "OK" << endl;
+	return 0;
+}
@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <vector>
+
+/**
+ * std::vector based reference implementation of the range sequence interface
+ */
+template<class T>
+struct vector_range_sequence {
+	std::vector<T> v;
+
+	void insert_at(int pos, const T& val) {v.insert(v.begin()+pos, val);}
+	void erase_at(int pos) {v.erase(v.begin()+pos);}
+	T at(int pos) {return v[pos];}
+	unsigned size() {return v.size();}
+
+	void reverse(int first, int last) {std::reverse(v.begin()+first, v.begin()+last);}
+	void add(int first, int last, const T& d) {for(int i = first; i < last; i++) v[i] += d;}
+	void assign(int first, int last, const T& x) {std::fill(v.begin()+first, v.begin()+last, x);}
+
+	T sum(int first, int last) {
+		T s = T();
+		for(int i = first; i < last; i++) s += v[i];
+		return s;
+	}
+
+	T min(int first, int last) {return *std::min_element(v.begin()+first, v.begin()+last);}
+	T max(int first, int last) {return *std::max_element(v.begin()+first, v.begin()+last);}
+};
+
+vector_range_sequence<long long> seq;
+
+#include "range_sequence_randomized_stress_test.cpp"
@@ -0,0 +1,28 @@
+#include <vector>
+
+/**
+ * std::vector based reference implementation of the sequence interface
+ */
+template<class T>
+struct vector_sequence {
+	std::vector<T> v;
+
+	void insert_at(int pos, const T& val) {v.insert(v.begin()+pos, val);}
+	void erase_at(int pos) {v.erase(v.begin()+pos);}
+	T& at(int pos) {return v[pos];}
+	unsigned size() {return v.size();}
+
+	void split_at(int pos, vector_sequence<T>& right) {
+		right.v.assign(v.begin()+pos, v.end());
+		v.resize(pos);
+	}
+
+	void concat(vector_sequence<T>& other) {
+		v.insert(v.end(), other.v.begin(), other.v.end());
+		other.v.clear();
+	}
+};
+
+vector_sequence<int> seq, rest;
+
+#include "sequence_randomized_stress_test.cpp"
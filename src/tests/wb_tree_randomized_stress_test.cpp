@@ -0,0 +1,5 @@
+#include "../wb_tree.hpp"
+
+WBTree<int> bst;
+
+#include "randomized_stress_test.cpp"
\ No newline at end of file
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Operation traces, to replay the calls a tree saw in production
+ * against any tree in the lab.
+ *
+ * File layout: a header, then fixed size records of one op code byte and
+ * its argument, the key (T, raw bytes) or the rank (int32), packed without
+ * padding, e.g. 5 bytes per operation for int keys. Fixed size records
+ * let a reader seek and count without parsing.
+ *
+ * trace_writer appends records through a buffer. recording_tree compiles
+ * around any tree (the engines here or __gnu_pbds::tree) and writes every
+ * call it forwards. trace_reader maps a trace read only and walks it front
+ * to back, handing the pages behind the cursor back to the kernel, so a
+ * trace of many GB streams through a small resident set.
+ *
+ * T must be trivially copyable, and a trace is only read back with the
+ * same key size (checked on open). Linux only.
+ */
+
+enum trace_op : std::uint8_t {
+    trace_insert,         // key
+    trace_erase,          // key, also erase through an iterator
+    trace_find,           // key
+    trace_order_of_key,   // key
+    trace_find_by_order,  // rank
+    trace_erase_by_order  // rank
+};
+
+template<class T>
+struct trace_record {
+    trace_op op;
+    T key;
+    std::int32_t rank;
+};
+
+template<class T>
+struct trace_format {
+    static_assert(std::is_trivially_copyable<T>::value,"keys are stored in the trace as raw bytes");
+
+    struct header {
+        char magic[8];
+        std::uint32_t key_size;
+        std::uint32_t record_size;
+    };
+
+    static const std::size_t ARG_BYTES = sizeof(T)>sizeof(std::int32_t) ? sizeof(T) : sizeof(std::int32_t);
+    static const std::size_t RECORD_BYTES = 1+ARG_BYTES;
+
+    static const char* magic() {
+        return "BSTRACE";
+    }
+
+    static bool takes_rank(trace_op op) {
+        return op==trace_find_by_order || op==trace_erase_by_order;
+    }
+};
+
+template<class T>
+class trace_writer {
+    typedef trace_format<T> format;
+
+    static const std::size_t BUFFER_BYTES = 1<<20;
+
+    int fd = -1;
+    std::vector<unsigned char> buffer;
+    std::uint64_t written = 0;
+    bool failed = false;
+
+    bool flush() {
+        const unsigned char* p = buffer.data();
+        std::size_t left = buffer.size();
+        while(left>0 && !failed) {
+            ssize_t n = ::write(fd,p,left);
+            if(n<=0) failed = true;
+            else {
+                p += n;
+                left -= n;
+            }
+        }
+        buffer.clear();
+        return !failed;
+    }
+
+    void append(trace_op op,const void* arg,std::size_t bytes) {
+        if(fd<0) return;
+        std::size_t at = buffer.size();
+        buffer.resize(at+format::RECORD_BYTES);
+        buffer[at] = op;
+        std::memcpy(&buffer[at+1],arg,bytes);
+        written++;
+        if(buffer.size()+format::RECORD_BYTES>BUFFER_BYTES) flush();
+    }
+
+    public:
+    trace_writer() {}
+    trace_writer(const trace_writer&) = delete;
+    trace_writer& operator=(const trace_writer&) = delete;
+
+    /**
+     * creates or truncates path and writes the header
+     * returns false if the file can't be created
+     */
+    bool open(const char* path) {
+        close();
+        fd = ::open(path,O_WRONLY|O_CREAT|O_TRUNC,0644);
+        if(fd<0) return false;
+
+        failed = false;
+        written = 0;
+        buffer.reserve(BUFFER_BYTES);
+        typename format::header h = {};
+        std::memcpy(h.magic,format::magic(),sizeof(h.magic));
+        h.key_size = sizeof(T);
+        h.record_size = format::RECORD_BYTES;
+        buffer.resize(sizeof(h));
+        std::memcpy(buffer.data(),&h,sizeof(h));
+        return true;
+    }
+
+    bool is_open() {
+        return fd>=0;
+    }
+
+    void write(trace_op op,const T& key) {
+        append(op,&key,sizeof(T));
+    }
+
+    void write_rank(trace_op op,std::int32_t rank) {
+        append(op,&rank,sizeof(rank));
+    }
+
+    /**
+     * records written since open
+     */
+    std::uint64_t records() {
+        return written;
+    }
+
+    /**
+     * flushes and closes the file
+     * returns false if some write failed, the trace is then truncated
+     */
+    bool close() {
+        if(fd<0) return true;
+        bool ok = flush();
+        ok = ::close(fd)==0 && ok;
+        fd = -1;
+        return ok;
+    }
+
+    ~trace_writer() {
+        close();
+    }
+};
+
+template<class T>
+class trace_reader {
+    typedef trace_format<T> format;
+
+    /**
+     * pages more than this far behind the cursor are dropped
+     */
+    static const std::size_t WINDOW_BYTES = std::size_t(64)<<20;
+
+    int fd = -1;
+    const unsigned char* base = nullptr;
+    std::size_t mapped_bytes = 0;
+    std::size_t pos = 0;
+    std::size_t dropped = 0; // bytes from the start already handed back
+
+    /**
+     * unmaps and closes whatever is open, always returns false
+     * so that open can bail out with return fail()
+     */
+    bool fail() {
+        if(base!=nullptr) munmap(const_cast<unsigned char*>(base),mapped_bytes);
+        if(fd>=0) ::close(fd);
+        base = nullptr;
+        fd = -1;
+        mapped_bytes = 0;
+        return false;
+    }
+
+    public:
+    trace_reader() {}
+    trace_reader(const trace_reader&) = delete;
+    trace_reader& operator=(const trace_reader&) = delete;
+
+    /**
+     * maps the trace in path
+     * returns false if it can't be mapped or was written with another key size
+     */
+    bool open(const char* path) {
+        close();
+        fd = ::open(path,O_RDONLY);
+        if(fd<0) return false;
+
+        struct stat st;
+        if(fstat(fd,&st)!=0 || std::size_t(st.st_size)<sizeof(typename format::header)) return fail();
+        mapped_bytes = st.st_size;
+
+        void* p = mmap(nullptr,mapped_bytes,PROT_READ,MAP_PRIVATE,fd,0);
+        if(p==MAP_FAILED) return fail();
+        base = static_cast<const unsigned char*>(p);
+        madvise(p,mapped_bytes,MADV_SEQUENTIAL);
+
+        typename format::header h;
+        std::memcpy(&h,base,sizeof(h));
+        if(std::memcmp(h.magic,format::magic(),sizeof(h.magic))!=0 || h.key_size!=sizeof(T)
+           || h.record_size!=format::RECORD_BYTES) {
+            return fail();
+        }
+
+        rewind();
+        return true;
+    }
+
+    bool is_open() {
+        return base!=nullptr;
+    }
+
+    /**
+     * number of complete records, a record torn by a crashed writer is ignored
+     */
+    std::uint64_t size() {
+        if(base==nullptr) return 0;
+        return (mapped_bytes-sizeof(typename format::header))/format::RECORD_BYTES;
+    }
+
+    /**
+     * back to the first record, the pages are read again
+     */
+    void rewind() {
+        pos = sizeof(typename format::header);
+        dropped = 0;
+    }
+
+    /**
+     * reads the next record into r, returns false at the end of the trace
+     */
+    bool next(trace_record<T>& r) {
+        if(base==nullptr || pos+format::RECORD_BYTES>mapped_bytes) return false;
+
+        r.op = trace_op(base[pos]);
+        if(format::takes_rank(r.op)) std::memcpy(&r.rank,base+pos+1,sizeof(r.rank));
+        else std::memcpy(&r.key,base+pos+1,sizeof(T));
+        pos += format::RECORD_BYTES;
+
+        if(pos-dropped>=2*WINDOW_BYTES) {
+            std::size_t page = sysconf(_SC_PAGESIZE);
+            std::size_t until = (pos-WINDOW_BYTES)/page*page;
+            madvise(const_cast<unsigned char*>(base)+dropped,until-dropped,MADV_DONTNEED);
+            dropped = until;
+        }
+        return true;
+    }
+
+    void close() {
+        fail();
+    }
+
+    ~trace_reader() {
+        close();
+    }
+};
+
+/**
+ * Tree that records every call into a trace before forwarding it
+ * Tree is any tree with the interface of the ones here, the calls it does
+ * not have (erase_by_order on __gnu_pbds::tree) are simply never used.
+ * Erasing through an iterator is recorded as an erase of its key.
+ * Nothing is recorded before record_to or after stop_recording.
+ */
+template<class Tree>
+class recording_tree : public Tree {
+    public:
+    typedef typename std::decay<decltype(*std::declval<Tree&>().begin())>::type key_type;
+
+    private:
+    trace_writer<key_type> trace;
+
+    template<class K>
+    void record_erase(const K& key,std::true_type) {
+        trace.write(trace_erase,key);
+    }
+
+    template<class It>
+    void record_erase(const It& it,std::false_type) {
+        if(it!=Tree::end()) trace.write(trace_erase,*it);
+    }
+
+    public:
+    /**
+     * starts a new trace in path, returns false if it can't be created
+     */
+    bool record_to(const char* path) {
+        return trace.open(path);
+    }
+
+    /**
+     * returns false if some record could not be written
+     */
+    bool stop_recording() {
+        return trace.close();
+    }
+
+    std::uint64_t recorded() {
+        return trace.records();
+    }
+
+    decltype(auto) insert(const key_type& key) {
+        trace.write(trace_insert,key);
+        return Tree::insert(key);
+    }
+
+    template<class A>
+    decltype(auto) erase(const A& a) {
+        record_erase(a,std::is_convertible<A,key_type>());
+        return Tree::erase(a);
+    }
+
+    decltype(auto) find(const key_type& key) {
+        trace.write(trace_find,key);
+        return Tree::find(key);
+    }
+
+    decltype(auto) order_of_key(const key_type& key) {
+        trace.write(trace_order_of_key,key);
+        return Tree::order_of_key(key);
+    }
+
+    decltype(auto) find_by_order(int k) {
+        trace.write_rank(trace_find_by_order,k);
+        return Tree::find_by_order(k);
+    }
+
+    decltype(auto) erase_by_order(int k) {
+        trace.write_rank(trace_erase_by_order,k);
+        return Tree::erase_by_order(k);
+    }
+};
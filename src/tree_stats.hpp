@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/**
+ * Memory and shape introspection shared by the tree headers, for sampling
+ * from a metrics endpoint.
+ *
+ * Both come in two modes:
+ * - stats_approximate: from the counts the tree keeps and a fixed number
+ *   of sampled root to node descents, O(log n), cheap enough to call on
+ *   every scrape
+ * - stats_exact: one walk over every node, O(n)
+ *
+ * node must have child[2] (left, right) and size fields, NILL terminated.
+ * The walks use an explicit stack, so a degenerate (splay) tree does not
+ * overflow the call stack.
+ */
+
+enum stats_mode {stats_approximate,stats_exact};
+
+struct tree_memory_usage {
+    std::size_t nodes = 0;              // allocated, tombstones included
+    std::size_t node_size = 0;          // sizeof(node), key and augmentation included
+    std::size_t heap_nodes = 0;         // allocated one by one with new
+    std::size_t block_nodes = 0;        // moved into relayout blocks
+    std::size_t node_bytes = 0;         // nodes*node_size
+    std::size_t allocator_overhead = 0; // malloc headers and rounding, unused slots of blocks
+    std::size_t auxiliary_bytes = 0;    // the tree object, lookup cache, negative filter, relayout scratch
+    std::size_t total_bytes = 0;
+    bool exact = false;
+
+    double bytes_per_node() const {
+        return nodes==0 ? 0.0 : (double)total_bytes/nodes;
+    }
+};
+
+struct tree_shape_stats {
+    std::size_t nodes = 0;
+    int max_depth = -1;                       // the root is at depth 0, -1 for an empty tree
+    double average_depth = 0;
+    std::vector<std::size_t> depth_histogram; // [d] = nodes at depth d
+    unsigned long long rotations = 0;         // since the tree was created
+    int black_height = -1;                    // RBTree only, black nodes on every path down, NILL excluded
+    bool exact = false;
+};
+
+/**
+ * bytes glibc malloc takes for a request of n bytes: a size_t header,
+ * rounded up to 2*sizeof(size_t), at least 4*sizeof(size_t)
+ */
+inline std::size_t malloc_chunk_bytes(std::size_t n) {
+    const std::size_t align = 2*sizeof(std::size_t);
+    std::size_t chunk = (n+sizeof(std::size_t)+align-1)/align*align;
+    return chunk<2*align ? 2*align : chunk;
+}
+
+/**
+ * bytes the allocator holds for the node x allocated with new
+ * the exact mode asks glibc where it is available
+ */
+template<class node>
+std::size_t heap_node_bytes(node* x,stats_mode mode) {
+#if defined(__GLIBC__)
+    if(mode==stats_exact) return malloc_usable_size(x)+sizeof(std::size_t);
+#else
+    (void)x;
+    (void)mode;
+#endif
+    return malloc_chunk_bytes(sizeof(node));
+}
+
+/**
+ * Memory of the tree rooted at root. The approximate mode takes nodes and
+ * block_nodes (live nodes of the relayout blocks) as counted by the tree
+ * and assumes the malloc chunk size for the rest, the exact mode counts
+ * the nodes and asks in_block(x) where every one of them lives.
+ * block_bytes are the relayout blocks, after a splay_tree split or join
+ * they may be shared with other trees and are counted in each of them.
+ * Memory owned by the keys themselves (the buffer of a long std::string)
+ * is not included.
+ */
+template<class node,class InBlock>
+tree_memory_usage measure_memory(node* root,node* nill,std::size_t nodes,std::size_t block_nodes,
+    std::size_t block_bytes,std::size_t auxiliary_bytes,stats_mode mode,InBlock in_block) {
+    tree_memory_usage m;
+    m.node_size = sizeof(node);
+    m.exact = mode==stats_exact;
+    std::size_t heap_bytes = 0;
+
+    if(mode==stats_exact) {
+        std::vector<node*> stack;
+        if(root!=nill) stack.push_back(root);
+        while(!stack.empty()) {
+            node* x = stack.back();
+            stack.pop_back();
+            m.nodes++;
+            if(in_block(x)) {
+                m.block_nodes++;
+            } else {
+                m.heap_nodes++;
+                heap_bytes += heap_node_bytes(x,mode);
+            }
+            for(int d=0;d<2;d++) {
+                if(x->child[d]!=nill) stack.push_back(x->child[d]);
+            }
+        }
+    } else {
+        m.nodes = nodes;
+        m.block_nodes = block_nodes<nodes ? block_nodes : nodes;
+        m.heap_nodes = nodes-m.block_nodes;
+        heap_bytes = m.heap_nodes*malloc_chunk_bytes(sizeof(node));
+    }
+
+    m.node_bytes = m.nodes*sizeof(node);
+    std::size_t block_used = m.block_nodes*sizeof(node);
+    m.allocator_overhead = heap_bytes-m.heap_nodes*sizeof(node) + (block_bytes>block_used ? block_bytes-block_used : 0);
+    m.auxiliary_bytes = auxiliary_bytes;
+    m.total_bytes = m.node_bytes+m.allocator_overhead+m.auxiliary_bytes;
+    return m;
+}
+
+/**
+ * Depths of the tree rooted at root. The exact mode visits every node.
+ * The approximate mode descends to SAMPLES ranks spread evenly over the
+ * live elements (weight(x) is 1 for a live node, 0 for a tombstone, sizes
+ * count live nodes) and scales their depths to nodes, its max_depth is
+ * the deepest sample, a lower bound that the tree may replace with what
+ * it knows.
+ */
+template<class node,class Weight>
+tree_shape_stats measure_shape(node* root,node* nill,std::size_t nodes,stats_mode mode,Weight weight) {
+    const int SAMPLES = 64;
+
+    tree_shape_stats s;
+    s.exact = mode==stats_exact;
+    if(root==nill) return s;
+
+    if(mode==stats_exact) {
+        std::vector<std::pair<node*,int>> stack(1,std::make_pair(root,0));
+        double depth_sum = 0;
+        while(!stack.empty()) {
+            node* x = stack.back().first;
+            int depth = stack.back().second;
+            stack.pop_back();
+            if((int)s.depth_histogram.size()<=depth) s.depth_histogram.resize(depth+1);
+            s.depth_histogram[depth]++;
+            depth_sum += depth;
+            for(int d=0;d<2;d++) {
+                if(x->child[d]!=nill) stack.push_back(std::make_pair(x->child[d],depth+1));
+            }
+        }
+        for(std::size_t count : s.depth_histogram) s.nodes += count;
+        s.max_depth = (int)s.depth_histogram.size()-1;
+        s.average_depth = depth_sum/s.nodes;
+        return s;
+    }
+
+    s.nodes = nodes;
+    int live = root->size;
+    if(live==0) return s;
+    int samples = live<SAMPLES ? live : SAMPLES;
+    std::vector<int> found;
+    double depth_sum = 0;
+    for(int i=0;i<samples;i++) {
+        int k = (int)((2LL*i+1)*live/(2LL*samples));
+        node* x = root;
+        int depth = 0;
+        while(true) {
+            int left = x->child[0]->size;
+            if(k<left) {
+                x = x->child[0];
+            } else {
+                k -= left;
+                int w = weight(x);
+                if(k<w) break;
+                k -= w;
+                x = x->child[1];
+            }
+            depth++;
+        }
+        if((int)found.size()<=depth) found.resize(depth+1);
+        found[depth]++;
+        depth_sum += depth;
+    }
+
+    s.max_depth = (int)found.size()-1;
+    s.average_depth = depth_sum/samples;
+    s.depth_histogram.resize(found.size());
+    for(std::size_t d=0;d<found.size();d++) s.depth_histogram[d] = (std::size_t)((double)found[d]*nodes/samples+0.5);
+    return s;
+}
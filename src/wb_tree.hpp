@@ -0,0 +1,557 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "balancing.hpp"
+#include "batch_traversal.hpp"
+#include "parallel_traversal.hpp"
+#include "tree_stats.hpp"
+
+/**
+ * Weight Balanced Tree Class (BB[alpha])
+ * Can't insert the same key more than once
+ *
+ * Balance is kept purely on the subtree sizes that are already maintained
+ * for the order statistic queries, so a node stores no height or color.
+ * The weight of a subtree is its size+1. A node is balanced when
+ * DELTA*weight(left) >= weight(right) and DELTA*weight(right) >= weight(left).
+ * (DELTA,GAMMA) = (3,2) are the integer parameters shown to be correct for
+ * bottom-up rebalancing by Hirai and Yamamoto.
+ */
+
+template<class T,typename Comp = std::less<T>>
+class WBTree {
+
+    struct node {
+        T key;
+        int size = 0;
+        node* child[2]; // left, right
+        node* parent;
+
+        node(const T& key,node* left,node* right,node* parent) : key(key), size(1),
+        child{left,right}, parent(parent) {}
+
+        node() : child{nullptr,nullptr},parent(nullptr) {}
+    };
+
+    static const int DELTA = 3;
+    static const int GAMMA = 2;
+
+    Comp comp;
+
+    static node NULL_NODE;
+    static node* NILL;
+
+    static node* successor(node* x) {
+        if(x->child[1]!=NILL) {
+            x=x->child[1];
+            while(x->child[0]!=NILL) x=x->child[0];
+            return x;
+        }
+
+        node* y = x->parent;
+        while(y!=NILL && y->child[1]==x) {
+            x = y;
+            y = x->parent;
+        }
+
+        return y;
+    }
+
+    static node* predecessor(node* x) {
+        if(x->child[0]!=NILL) {
+            x=x->child[0];
+            while(x->child[1]!=NILL) {
+                x=x->child[1];
+            }
+            return x;
+        }
+
+        node* y = x->parent;
+        while(y!=NILL && y->child[0]==x) {
+            x = y;
+            y = x->parent;
+        }
+
+        return y;
+    }
+
+
+    /**
+     * private helper function
+     * to help destructor to deallocate all memory
+     * recursively in linear time
+     */
+    void erase_sub_tree(node* x) {
+        if(x==NILL) return;
+        erase_sub_tree(x->child[0]);
+        erase_sub_tree(x->child[1]);
+        delete x;
+    }
+
+    class iterator {
+        friend class WBTree<T,Comp>;
+        node* it;
+        iterator(node* iter) : it(iter) {}
+    public:
+        iterator() {};
+
+        iterator& operator++() {
+            it = successor(it);
+            return *this;
+        }
+
+        iterator& operator--() {
+            it = predecessor(it);
+            return *this;
+        }
+
+        T operator*() const {return it->key;}
+        bool operator==(const iterator& rhs) const {return it==rhs.it;}
+        bool operator!=(const iterator& rhs) const {return it!=rhs.it;}
+        iterator& operator=(const iterator& rhs) {
+            it = rhs.it;
+            return *this;
+        }
+
+    };
+
+    node* root = NILL;
+    unsigned long long rotation_count = 0;
+
+
+    inline void relax_augmentation(node* x) {
+        x->size = x->child[0]->size + x->child[1]->size + 1;
+    }
+
+    /**
+     * the shared rotations (balancing.hpp) on this tree, with
+     * relax_augmentation as their augmentation hook
+     */
+    auto engine() {
+        return make_balancer(root,NILL,[this](node* x) {relax_augmentation(x);},&rotation_count);
+    }
+
+    /**
+     * x is too heavy on side !d, it goes down to side d
+     * a single rotation is enough unless the inner grandchild
+     * is too heavy compared to the outer one
+     */
+    void rotate(node* x,int d) {
+        node* c = x->child[!d];
+        if(c->child[d]->size+1 >= GAMMA*(c->child[!d]->size+1)) engine().single_rotate(c,!d);
+        engine().single_rotate(x,d);
+    }
+
+    /**
+     * locally modifies tree
+     * updates augmentation
+     * rebalances tree if there is a weight balance violation at node x
+     * assuming both children of x are balanced and have valid sizes
+     */
+    void rebalance(node* x) {
+        int wl = x->child[0]->size+1;
+        int wr = x->child[1]->size+1;
+        if(DELTA*wl<wr) rotate(x,0);
+        else if(DELTA*wr<wl) rotate(x,1);
+        else relax_augmentation(x);
+    }
+
+    /**
+     * given a node x in a subtree rooted at r
+     * where there is a balance or augmentation violation
+     * fix_tree(x,r) modifies the subtree and brings it
+     * back to a valid weight balanced state
+     */
+    void fix_tree(node* x,node* r) {
+        while(x!=NILL && x!=r->parent) {
+            rebalance(x);
+            x=x->parent;
+        }
+    }
+
+
+
+    /**
+     * takes z out of the tree and rebalances, without freeing it
+     * z can't be NILL
+     */
+    void unlink(node* z) {
+        if(z->child[0]==NILL) {
+            engine().transplant(z,z->child[1]);
+            fix_tree(z->parent,root);
+        } else if(z->child[1]==NILL) {
+            engine().transplant(z,z->child[0]);
+            fix_tree(z->parent,root);
+        } else {
+            node* y = successor(z); //y is not NILL and y has no left child cause z->child[1] is not NILL
+            if(y->parent!=z) {
+                engine().transplant(y,y->child[1]);
+                fix_tree(y->parent,z);
+
+                y->child[1] = z->child[1];
+                y->child[1]->parent = y;
+            }
+
+            engine().transplant(z,y);
+            y->child[0] = z->child[0];
+            y->child[0]->parent = y;
+
+            fix_tree(y,root);
+        }
+    }
+
+    /**
+     * A helper function for the erase(iterator) method
+     * z can't be NILL
+     */
+    void erase(node* z) {
+        unlink(z);
+        delete z;
+    }
+
+    /**
+     * hangs z, unlinked and holding its new key, into the tree as a leaf
+     * and rebalances, returns its rank
+     * there must be no node equivalent to z->key
+     */
+    int link(node* z) {
+        node* y = NILL;
+        node* x = root;
+        int rank = 0;
+        bool r = false;
+        while(x!=NILL) {
+            y = x;
+            r = comp(x->key,z->key);
+            rank += r ? x->child[0]->size+1 : 0;
+            x = x->child[r];
+        }
+
+        z->child[0] = z->child[1] = NILL;
+        z->parent = y;
+        z->size = 1;
+        if(y==NILL) root = z;
+        else y->child[r] = z;
+
+        fix_tree(z,root);
+        return rank;
+    }
+
+    /**
+     * number of nodes before x, one walk up to the root
+     */
+    int rank_of(node* x) {
+        int rank = x->child[0]->size;
+        for(;x->parent!=NILL;x=x->parent) {
+            if(x==x->parent->child[1]) rank += x->parent->child[0]->size+1;
+        }
+        return rank;
+    }
+
+    /**
+     * returns the node holding a key equivalent to val or NILL
+     * K is T or, with a transparent comparator, any type Comp can compare with T
+     * one comparison per level and x = x->child[comp(x->key,val)] steps
+     * without an early exit, the smallest node on the path that is not
+     * smaller than val is the only one that can match
+     */
+    template<class K>
+    node* find_node(const K& val) {
+        node* x = root;
+        node* candidate = NILL;
+        while(x!=NILL) {
+            bool r = comp(x->key,val);
+            candidate = r ? candidate : x;
+            x = x->child[r];
+        }
+        if(candidate==NILL || comp(val,candidate->key)) return NILL;
+        return candidate;
+    }
+
+    /**
+     * returns number of nodes smaller than val
+     * only uses comp, one comparison per level
+     */
+    template<class K>
+    int order_of_key_node(const K& val) {
+        node* x = root;
+        int p = 0;
+        while(x!=NILL) {
+            bool r = comp(x->key,val);
+            p += r ? x->child[0]->size+1 : 0;
+            x = x->child[r];
+        }
+
+        return p;
+    }
+
+    public:
+    /**
+     * the type of the comparator the keys are ordered by
+     */
+    typedef Comp key_compare;
+
+    iterator find(const T& val) {
+        return iterator(find_node(val));
+    }
+
+    /**
+     * heterogeneous lookup
+     * only takes part in overload resolution when Comp::is_transparent exists
+     */
+    template<class K,class C = Comp,class = typename C::is_transparent>
+    iterator find(const K& val) {
+        return iterator(find_node(val));
+    }
+
+    /**
+     * Inserts a new node into the tree and rebalances it accordingly
+     * to preserve weight balance if the node is not present
+     * If the value already exists in the tree it does nothing.
+     * Returns an iterator to the element equivalent to val and its rank,
+     * counted on the way down, whether it was inserted or already present
+     */
+    std::pair<iterator,int> insert(const T& val) {
+        node* y = NILL;
+        node* x = root;
+        node* candidate = NILL; // smallest node on the path not smaller than val
+        int rank = 0;
+        int candidate_rank = 0;
+        bool r = false;
+
+        while(x!=NILL) {
+            y = x;
+            r = comp(x->key,val);
+            candidate = r ? candidate : x;
+            candidate_rank = r ? candidate_rank : rank;
+            rank += r ? x->child[0]->size+1 : 0;
+            x = x->child[r];
+        }
+
+        if(candidate!=NILL && !comp(val,candidate->key)) {
+            return std::make_pair(iterator(candidate),candidate_rank+candidate->child[0]->size); //value already in tree
+        }
+
+        node* z = new node(val,NILL,NILL,NILL);
+        z->parent = y;
+
+        if(y==NILL) root = z;
+        else y->child[r] = z;
+
+        fix_tree(z,root);
+        return std::make_pair(iterator(z),rank);
+    }
+
+    void erase(iterator it) {
+        erase(it.it);
+    }
+
+    /**
+     * Erases the element equivalent to val, one descent
+     * returns false if there is none
+     */
+    bool erase(const T& val) {
+        node* z = find_node(val);
+        if(z==NILL) return false;
+        erase(iterator(z));
+        return true;
+    }
+
+    /**
+     * Changes the key of the element at it to new_key and returns its new rank.
+     * If new_key still falls strictly between the neighbouring elements the
+     * key is replaced in place without any rebalancing, otherwise the node
+     * is unlinked and hung back in at its new place. Either way the node is
+     * neither freed nor reallocated, it and all other iterators stay valid.
+     * Returns -1 and changes nothing if another element is equivalent to new_key.
+     */
+    int update_key(iterator it,const T& new_key) {
+        node* z = it.it;
+        node* prev = predecessor(z);
+        node* next = successor(z);
+        if((prev==NILL || comp(prev->key,new_key)) && (next==NILL || comp(new_key,next->key))) {
+            z->key = new_key;
+            return rank_of(z);
+        }
+
+        node* other = find_node(new_key);
+        if(other!=NILL && other!=z) return -1;
+        unlink(z);
+        z->key = new_key;
+        return link(z);
+    }
+
+    /**
+     * Erases the kth smallest element, k is 0 indexed
+     * returns false if k is out of range
+     */
+    bool erase_by_order(int k) {
+        if(k<0 || k>=(int)root->size) return false;
+        erase(iterator(select_node(root,k)));
+        return true;
+    }
+
+
+
+    bool empty() {
+        return !(root->size);
+    }
+
+    unsigned size() {
+        return root->size;
+    }
+
+    /**
+     * Number of single rotations performed since the tree was created
+     */
+    unsigned long long rotations() {
+        return rotation_count;
+    }
+
+    /**
+     * Bytes used by the nodes and the allocator, see tree_stats.hpp.
+     * The approximate mode is O(1) in the number of nodes, the exact mode
+     * walks them.
+     */
+    tree_memory_usage memory_usage(stats_mode mode = stats_approximate) {
+        return measure_memory(root,NILL,root->size,0,0,sizeof(*this),mode,[](node*) {return false;});
+    }
+
+    /**
+     * Depth histogram, average and max depth and rotations, see tree_stats.hpp.
+     * The approximate mode samples O(log n) descents, its max depth is the
+     * deepest sample, a lower bound of the real one.
+     */
+    tree_shape_stats shape_stats(stats_mode mode = stats_approximate) {
+        tree_shape_stats s = measure_shape(root,NILL,root->size,mode,[](node*) {return 1;});
+        s.rotations = rotation_count;
+        return s;
+    }
+
+    iterator begin() {
+        node* x = root;
+        if(x!=NILL) {
+            while(x->child[0]!=NILL) {
+                x=x->child[0];
+            }
+        }
+        return iterator(x);
+    }
+
+    iterator end() {
+        return iterator(NILL);
+    }
+
+    void print(iterator it) {
+	    std::cout << it.it->key << " " << it.it->size << std::endl;
+    }
+
+
+
+    /**
+     * Finds the kth smallest node
+     * k is 0 indexed
+     */
+    iterator find_by_order(int k) {
+        k++;
+        node* x = root;
+        while(x!=NILL) {
+            if(x->child[0]->size>=k) x = x->child[0];
+            else if(x->child[0]->size+1==k) return iterator(x);
+            else {
+                k-=(x->child[0]->size+1);
+                x = x->child[1];
+            }
+        }
+
+        return iterator(x);
+    }
+
+    /**
+     * returns number of nodes smaller than val
+     *
+     */
+    int order_of_key(const T& val) {
+        return order_of_key_node(val);
+    }
+
+    template<class K,class C = Comp,class = typename C::is_transparent>
+    int order_of_key(const K& val) {
+        return order_of_key_node(val);
+    }
+
+    /**
+     * out[i] = the key of rank ranks[i], for every i, in one shared traversal
+     * O(k log(n/k)) for k ranks instead of k separate descents
+     * ranks must be sorted and 0 <= ranks[i] < size()
+     */ 
+    void select_many(const std::vector<int>& ranks,std::vector<T>& out) {
+        out.resize(ranks.size());
+        select_many_nodes(root,NILL,ranks,[](node*) {return 1;},[&out](int i,node* x) {
+            out[i] = x->key;
+        });
+    }
+
+    /**
+     * out[i] = order_of_key(keys[i]), for every i, in one shared traversal
+     * keys must be sorted by Comp
+     */ 
+    void rank_many(const std::vector<T>& keys,std::vector<int>& out) {
+        out.resize(keys.size());
+        rank_many_nodes(root,NILL,keys,[this](node* x,const T& key) {return comp(x->key,key);},
+            [](node*) {return 1;},[&out](int i,int rank) {out[i] = rank;});
+    }
+
+    /**
+     * calls f(key) on every key, the keys are split into rank ranges of
+     * equal length that are processed in parallel, in order within a range
+     * f must be safe to call concurrently
+     * the tree must not be modified until it returns
+     * num_threads = 0 uses std::thread::hardware_concurrency()
+     */
+    template<class F>
+    void parallel_for_each(F f,unsigned num_threads = 0) {
+        unsigned chunks = parallel_rank_chunks(root->size,num_threads);
+        parallel_rank_ranges(root,chunks,[this](int k) {return select_node(root,k);},[&f](unsigned,node* x,int count) {
+            for(int i=0;i<count;i++,x=successor(x)) f(x->key);
+        });
+    }
+
+    /**
+     * returns init op k0 op k1 op ... op kn-1 over the keys in sorted order
+     * every rank range is folded on its own thread, then the partial results
+     * are combined in rank order, so the result is deterministic for an
+     * associative op (op does not need to be commutative)
+     * op takes two R, T must be convertible to R
+     */
+    template<class R,class Op>
+    R parallel_reduce(R init,Op op,unsigned num_threads = 0) {
+        if(root->size==0) return init;
+
+        unsigned chunks = parallel_rank_chunks(root->size,num_threads);
+        std::vector<R> partial(chunks,init);
+        parallel_rank_ranges(root,chunks,[this](int k) {return select_node(root,k);},[&](unsigned c,node* x,int count) {
+            R acc = x->key;
+            x = successor(x);
+            for(int i=1;i<count;i++,x=successor(x)) acc = op(acc,x->key);
+            partial[c] = acc;
+        });
+
+        for(unsigned c=0;c<chunks;c++) init = op(init,partial[c]);
+        return init;
+    }
+
+    ~WBTree() {
+        erase_sub_tree(root);
+    }
+};
+
+template<class T,class Comp>
+typename WBTree<T,Comp>::node WBTree<T,Comp>::NULL_NODE = {};
+
+
+template<class T,class Comp>
+typename WBTree<T,Comp>::node* WBTree<T,Comp>::NILL = &WBTree<T,Comp>::NULL_NODE;